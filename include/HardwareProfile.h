@@ -0,0 +1,101 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Compile-time description of one product variant: controller board, stepper driver and the
+// motor/gearbox/spool drive train. Everything the firmware derives from it (steps per cm, TSTEP
+// scale, position limits) folds into integer constants, so the motion paths never do float maths
+// at runtime. Select a variant with -D HARDWARE_PROFILE=<name> in its PlatformIO env.
+
+// GPIO assignment of the controller board
+template <int DirPin, int StepPin, int EnablePin, int ButtonPin>
+struct BoardPins
+{
+    static constexpr int DIR_PIN = DirPin;
+    static constexpr int STEP_PIN = StepPin;
+    static constexpr int ENABLE_PIN = EnablePin;
+    static constexpr int BUTTON_PIN = ButtonPin;
+};
+
+// TMC2209 wiring
+template <uint8_t Address, uint16_t RSenseMilliOhm, uint16_t RmsCurrentMa>
+struct Tmc2209Driver
+{
+    static constexpr uint8_t DRIVER_ADDRESS = Address; // According to MS1 and MS2
+    static constexpr uint16_t R_SENSE_MILLIOHM = RSenseMilliOhm;
+    static constexpr float R_SENSE = RSenseMilliOhm / 1000.0f;
+    static constexpr uint16_t RMS_CURRENT_MA = RmsCurrentMa;
+    static constexpr uint32_t DRIVER_CLOCK_HZ = 12000000; // Internal clock, the unit of TSTEP
+};
+
+// Stepper motor, gearbox (GearNumerator:GearDenominator) and the spool the string winds onto
+template <uint16_t FullStepsPerRev, uint16_t Microsteps, uint16_t GearNumerator, uint16_t GearDenominator,
+          uint16_t SpoolDiameterTenthMm>
+struct SpoolDrive
+{
+    static constexpr uint16_t FULL_STEPS_PER_REV = FullStepsPerRev;
+    static constexpr uint16_t MICROSTEPS = Microsteps;
+    static constexpr uint16_t GEAR_NUMERATOR = GearNumerator;
+    static constexpr uint16_t GEAR_DENOMINATOR = GearDenominator;
+    static constexpr uint16_t SPOOL_DIAMETER_TENTH_MM = SpoolDiameterTenthMm;
+};
+
+template <typename Board, typename Driver, typename Drive, uint32_t MaxSpeed, uint16_t MaxLimitCm>
+struct HardwareProfile : Board, Driver, Drive
+{
+    static constexpr uint32_t MAX_SPEED = MaxSpeed;      // steps/s
+    static constexpr uint16_t MAX_LIMIT_CM = MaxLimitCm; // Largest top/bottom limit
+
+    // Microsteps per spool revolution over the spool circumference, truncated like the original
+    // hand-computed constant so positions saved by older firmware stay valid
+    static constexpr uint32_t STEPS_PER_CM = static_cast<uint32_t>(
+        (1.0 * Drive::FULL_STEPS_PER_REV * Drive::MICROSTEPS * Drive::GEAR_NUMERATOR / Drive::GEAR_DENOMINATOR) /
+        (PI * Drive::SPOOL_DIAMETER_TENTH_MM / 100.0));
+    static constexpr int32_t MAX_POSITION = static_cast<int32_t>(MaxLimitCm) * static_cast<int32_t>(STEPS_PER_CM);
+
+    // TSTEP is the driver clock count between 1/256 microsteps: clock / (speed / microsteps * 256)
+    static constexpr uint32_t TSTEP_SCALE = Driver::DRIVER_CLOCK_HZ / 256 * Drive::MICROSTEPS;
+
+    static constexpr uint32_t tstep(uint32_t speed)
+    {
+        return TSTEP_SCALE / speed + 1;
+    }
+    // Slightly above nominal speed, to disable StallGuard and CoolStep when decelerating
+    static constexpr uint32_t tcoolthrs(uint32_t speed)
+    {
+        return tstep(speed) * 13 / 10;
+    }
+
+    static_assert(Board::DIR_PIN != Board::STEP_PIN && Board::STEP_PIN != Board::ENABLE_PIN &&
+                      Board::DIR_PIN != Board::ENABLE_PIN,
+                  "motor pins must be distinct");
+    static_assert(Driver::DRIVER_ADDRESS <= 3, "TMC2209 address is set by MS1/MS2 (0-3)");
+    static_assert(Driver::R_SENSE_MILLIOHM > 0, "sense resistor must be set");
+    static_assert(Drive::MICROSTEPS > 0 && Drive::MICROSTEPS <= 256 && (Drive::MICROSTEPS & (Drive::MICROSTEPS - 1)) == 0,
+                  "TMC2209 microsteps must be a power of two up to 256");
+    static_assert(Drive::GEAR_NUMERATOR > 0 && Drive::GEAR_DENOMINATOR > 0, "gear ratio must be positive");
+    static_assert(Drive::SPOOL_DIAMETER_TENTH_MM > 0, "spool diameter must be positive");
+    static_assert(Driver::DRIVER_CLOCK_HZ % 256 == 0, "TSTEP scale must be exact");
+    static_assert(STEPS_PER_CM >= 10, "less than 1 mm position resolution");
+    static_assert(static_cast<uint64_t>(MaxLimitCm) * STEPS_PER_CM <= INT32_MAX, "limits overflow the step position");
+    static_assert(MaxSpeed > 0 && tstep(MaxSpeed) >= 2, "max speed too fast for StallGuard (TSTEP)");
+    static_assert(tcoolthrs(1) < (1UL << 20), "TCOOLTHRS register is 20 bits");
+};
+
+using Esp32C6Board = BoardPins<18, 20, 23, 9>; // Boot button on GPIO 9 (ESP32-C6 DevKitC and XIAO)
+using Tmc2209Board = Tmc2209Driver<0b00, 110, 1500>;
+
+// 2.0 cm spool on a 14:3 (~4.667:1) gearbox, 1/8 microstepping (~1188 steps/cm)
+using CurtainV3 = HardwareProfile<Esp32C6Board, Tmc2209Board, SpoolDrive<200, 8, 14, 3, 200>, 15000, 400>;
+// 3.0 cm spool for long drops: 2/3 of the steps per cm (~792), so the same step range reaches 600 cm
+using CurtainV3LongDrop = HardwareProfile<Esp32C6Board, Tmc2209Board, SpoolDrive<200, 8, 14, 3, 300>, 15000, 600>;
+
+// Completing each profile type runs its static_asserts, so every variant is validated in every
+// build, not only the active one
+static_assert(CurtainV3::STEPS_PER_CM == 1188, "CurtainV3 must keep the original step scale");
+static_assert(sizeof(CurtainV3LongDrop) > 0, "CurtainV3LongDrop must be a complete hardware profile");
+
+#ifndef HARDWARE_PROFILE
+#define HARDWARE_PROFILE CurtainV3
+#endif
+using ActiveHardware = HARDWARE_PROFILE;
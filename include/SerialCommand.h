@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+#include "StepperUart.h"
+
+#define SERIAL_COMMAND_MAX_LINE 128 // Longest accepted request line, including batched commands
+#define SERIAL_COMMAND_MAX_BYTES_PER_POLL 256
+#define SERIAL_COMMAND_MAX_REPLY 256
+
+// Line-framed serial control protocol.
+//
+// Request:  [#tag] command [arg] [; command [arg] ...]\n
+// Response: <millis> <#tag|-> ok [key=value ...]\n
+//           <millis> <#tag|-> err <reason>\n
+// Event:    <millis> - evt stopped pos=<steps> lift=<percent>\n  (once per cover move, after back-off)
+//
+// Commands separated by ';' form a batch and are executed in order, one response each, all carrying
+// the request's tag. Commands: open (o), close (c), stop (s), home (h), goto <0-100>,
+// speed <1-MAX_SPEED>, sgthrs <0-144>, top <0-MAX_LIMIT_CM>, bottom <0-MAX_LIMIT_CM>, state, travel,
+// metrics, ping. MAX_SPEED and MAX_LIMIT_CM come from the active hardware profile (15000 steps/s and
+// 400 cm for CurtainV3); out-of-range values are rejected with the profile's range.
+// The old single-character commands remain: 1-5 select speed presets (1000, 2400, 5000, 7500,
+// 10000) and + / - step the stall sensitivity by 10.
+//
+// home replies as soon as homing starts; the evt stopped line marks its end.
+//
+// Commands go through the same functions as the Zigbee callbacks. Lines that do not start with a
+// timestamp are ordinary log output and can be ignored by host scripts.
+class SerialCommand
+{
+public:
+    SerialCommand(Stream &stream, StepperUart &motor);
+
+    // Reads whatever is buffered without blocking and executes complete lines.
+    void poll();
+
+private:
+    void handleLine(char *line);
+    void execute(const char *tag, char *command);
+    bool parseArgument(const char *tag, const char *arg, long min, long max, long &value);
+    void reply(const char *tag, const char *status, const char *format = nullptr, ...)
+        __attribute__((format(printf, 4, 5)));
+
+    Stream &stream;
+    StepperUart &motor;
+
+    char buffer[SERIAL_COMMAND_MAX_LINE];
+    size_t length;
+    bool overflow;
+    bool wasRunning;
+
+    uint32_t commandCount;
+    uint32_t errorCount;
+    uint32_t overflowCount;
+};
@@ -4,16 +4,20 @@
 #include <FastAccelStepper.h>
 #include <TMCStepper.h>
 #include <HardwareSerial.h>
+#include "HardwareProfile.h"
 
-#define DRIVER_ADDRESS 0b00 // TMC2209 Driver address according to MS1 and MS2
-#define R_SENSE 0.11f // Match to your driver
-
-class StepperUart
+// Pins, driver settings and microstepping come from the hardware profile
+template <typename Profile>
+class BasicStepperUart
 {
 public:
-    StepperUart(int dirPin, int stepPin, int enablePin);
+    BasicStepperUart();
     void init();
-    void setSpeed(float speed, int microsteps);
+    void setSpeed(uint32_t speed); // steps/s, clamped to 1..Profile::MAX_SPEED
+    uint32_t getSpeed()
+    {
+        return speed;
+    }
     void setSGTHRS(uint8_t threshold);
     uint8_t getSGTHRS()
     {
@@ -37,12 +41,12 @@ public:
 
     void enableMotor()
     {
-        digitalWrite(enablePin, LOW); // Enable the motor
+        digitalWrite(Profile::ENABLE_PIN, LOW); // Enable the motor
         motorEnabled = true;
     }
     void disableMotor()
     {
-        digitalWrite(enablePin, HIGH); // Disable the motor
+        digitalWrite(Profile::ENABLE_PIN, HIGH); // Disable the motor
         motorEnabled = false;
     }
     TMC2209Stepper getDriver()
@@ -56,12 +60,13 @@ private:
     FastAccelStepper *_stepper;
 
     HardwareSerial HWSerial = HardwareSerial(0);
-    TMC2209Stepper driver = TMC2209Stepper(&HWSerial, R_SENSE, DRIVER_ADDRESS);
+    TMC2209Stepper driver = TMC2209Stepper(&HWSerial, Profile::R_SENSE, Profile::DRIVER_ADDRESS);
 
     int32_t targetPosition;
-    float speed;
-    int enablePin;
-    int dirPin;
-    int stepPin;
+    uint32_t speed;
     bool motorEnabled;
 };
+
+// Only the active profile is built, in StepperUart.cpp
+extern template class BasicStepperUart<ActiveHardware>;
+using StepperUart = BasicStepperUart<ActiveHardware>;
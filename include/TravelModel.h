@@ -0,0 +1,123 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define TRAVEL_MODEL_VERSION 1
+#define TRAVEL_STATS_VERSION 1
+#define TRAVEL_MODEL_BINS 8                 // Position bins between the top and bottom limit
+#define TRAVEL_MODEL_LEARNING_RATE 0.2f     // Weight of a new observation
+#define TRAVEL_MODEL_MIN_SAMPLE_MS 100      // Shortest window used to observe speed
+#define TRAVEL_MODEL_ARRIVAL_TOLERANCE 16   // Steps from the target that still count as arrived
+
+enum TravelDirection
+{
+    TRAVEL_UP = 0, // Towards the top limit (decreasing position)
+    TRAVEL_DOWN = 1,
+};
+
+struct TravelModelParams
+{
+    uint8_t version;
+    float efficiency[2][TRAVEL_MODEL_BINS]; // Observed / commanded speed, per direction and position bin
+    float overheadMs[2];                    // Start latency, acceleration and lift back-off per trip
+};
+
+struct TravelErrorStats
+{
+    uint32_t trips;
+    float meanErrorMs; // Actual - predicted; positive means the blind arrived later than predicted
+    float meanAbsErrorMs;
+    float maxAbsErrorMs;
+};
+
+// Persisted separately from the params: they change on every trip but are only diagnostics, so
+// they are saved less often
+struct TravelModelStats
+{
+    uint8_t version;
+    TravelErrorStats direction[2];
+};
+
+// Learns how long the blind takes to travel, per direction and position, from completed trips.
+//
+// Each trip is sampled while it runs: steady-motion windows update the speed efficiency of the
+// position bin they fall in, and on arrival the time not explained by the bins is learned as a
+// per-direction overhead. Predictions are made before the move starts so their error can be
+// tracked against the actual arrival time.
+class TravelModel
+{
+public:
+    TravelModel();
+
+    void reset();
+    void setRange(int32_t topPosition, int32_t bottomPosition);
+
+    uint32_t predictDurationMs(int32_t from, int32_t to, float speed) const;
+    int32_t predictPosition(int32_t from, int32_t to, float speed, uint32_t elapsedMs) const;
+
+    void beginTrip(uint32_t nowMs, int32_t from, int32_t to, float speed);
+    void cancelTrip();
+    // Feeds the current position; returns true when this sample completed the trip.
+    bool sample(uint32_t nowMs, int32_t position, bool running);
+    // Re-anchors the remaining-time estimate on the actual position after the blind fell behind
+    // or ran ahead of the prediction.
+    void replan(uint32_t nowMs, int32_t position);
+
+    bool isTripActive() const
+    {
+        return tripActive;
+    }
+    int32_t getTripTarget() const
+    {
+        return tripTo;
+    }
+    TravelDirection getTripDirection() const
+    {
+        return tripDirection;
+    }
+    uint32_t remainingMs(uint32_t nowMs) const;
+    uint32_t overdueMs(uint32_t nowMs) const;
+    int32_t predictedPosition(uint32_t nowMs) const;
+
+    const TravelErrorStats &getErrorStats(TravelDirection direction) const
+    {
+        return stats[direction];
+    }
+    const TravelModelParams &getParams() const
+    {
+        return params;
+    }
+    bool setParams(const TravelModelParams &newParams);
+    TravelModelStats getStats() const;
+    bool setStats(const TravelModelStats &newStats);
+
+private:
+    int binOf(int32_t position) const;
+    int64_t binLowerEdge(int bin) const;
+    int64_t binUpperEdge(int bin) const;
+    float travel(int32_t from, int32_t to, float speed, float budgetMs, int32_t &reached) const;
+    void recordArrival(uint32_t nowMs);
+
+    TravelModelParams params;
+    TravelErrorStats stats[2];
+
+    int32_t rangeTop;
+    int32_t rangeBottom;
+
+    bool tripActive;
+    TravelDirection tripDirection;
+    int32_t tripFrom;
+    int32_t tripTo;
+    float tripSpeed;
+    uint32_t tripStartMs;
+    uint32_t tripPredictedMs;
+
+    uint32_t anchorMs; // Start of the current remaining-time estimate
+    int32_t anchorPosition;
+    uint32_t anchorPredictedMs;
+    bool anchorIncludesOverhead;
+
+    uint32_t lastSampleMs;
+    int32_t lastSamplePosition;
+    bool lastSampleRunning;
+};
@@ -2,6 +2,7 @@
 
 #include <Arduino.h>
 #include "StepperUart.h"
+#include "TravelModel.h"
 
 void updatePosition(int32_t currentPosition);
 
@@ -10,6 +11,37 @@ void closeCover();
 void stopCover();
 void goToLiftPercentage(uint8_t liftPercentage);
 void homingRoutine();
+// Runs the homing routine in its own task; stopCover() aborts it.
+void startHoming();
+// True from a move command until the cover has settled, including the pause between an upward
+// overshoot and its back-off.
+bool isCoverMoving();
+
+// Configuration setters shared by the Zigbee and serial command paths. They apply and persist the
+// value, then queue it for reporting so the coordinator stays in sync.
+void setCoverSpeed(float speed);
+void setCoverStallSensitivity(uint8_t sgthrs);
+void setCoverTopLimit(uint16_t topLimit);
+void setCoverBottomLimit(uint16_t bottomLimit);
+
+struct CoverState
+{
+    int32_t position;
+    int32_t targetPosition; // Where the cover move ends, after any overshoot and back-off
+    bool running;
+    float liftPercentage;
+    uint16_t topLimit;
+    uint16_t bottomLimit;
+    float speed;
+    uint8_t stallSensitivity;
+    uint32_t etaMs; // Predicted time until the current move arrives, 0 when idle
+};
+CoverState getCoverState();
+const TravelModel &getTravelModel();
+// True while the learned travel model and its error stats wait for their rate-limited save.
+bool hasPendingTravelModelSave();
+// True while attribute reports are queued, e.g. during the boot delay or a rate-limit window.
+bool hasPendingZigbeeReports();
 
 void createAndSetupZigbeeEndpoints();
 void readAndUpdateZigbeeCoverState(StepperUart &motor);
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define ZIGBEE_PUBLISHED_VERSION 2
+#define ZIGBEE_PUBLISH_INTERVAL_MS 100      // How often pending attributes are flushed
+#define ZIGBEE_MAX_FRAMES_PER_FLUSH 3       // Cap on reports sent in one flush
+#define ZIGBEE_BOOT_JITTER_MS 5000          // Boot reports are held back by a random delay up to this
+#define ZIGBEE_LIFT_MIN_INTERVAL_MS 1000    // Lift reports while moving; the settled lift is sent right away
+#define ZIGBEE_ETA_MIN_INTERVAL_MS 0
+#define ZIGBEE_CONFIG_MIN_INTERVAL_MS 1000
+
+enum ZigbeeAttribute
+{
+    ZB_ATTR_LIFT_PERCENTAGE = 0,
+    ZB_ATTR_STALL_SENSITIVITY,
+    ZB_ATTR_BOTTOM_LIMIT,
+    ZB_ATTR_TOP_LIMIT,
+    ZB_ATTR_SPEED,
+    ZB_ATTR_ETA,
+    ZB_ATTR_COUNT
+};
+
+// Last value the coordinator received for each persistent attribute, kept in NVS so a reboot does
+// not have to resend values the coordinator already has.
+struct ZigbeePublishedSnapshot
+{
+    uint8_t version;
+    uint8_t validMask;
+    int32_t values[ZB_ATTR_COUNT];
+};
+
+// Tracks dirty Zigbee attributes and publishes them from a periodic flush.
+//
+// Repeated updates between flushes coalesce into one report with the latest value, values equal to
+// the last published one (at the attribute's resolution) are skipped, and each attribute has a
+// minimum interval between reports. Reports that fail (e.g. Zigbee not started yet) stay pending.
+// The local attribute is always set to the latest value, even when its report is skipped.
+//
+// Values are integers in each attribute's own unit (percent, cm, steps/s, ms), so a flush does no
+// float maths; the apply and report functions convert to the Zigbee attribute type.
+//
+// set() and assumePublished() may be called from any task while a flush runs; a value set during
+// a report stays pending instead of being marked as sent.
+class ZigbeePublisher
+{
+public:
+    typedef bool (*ApplyFunction)(int32_t value);  // Sets the local attribute without reporting it
+    typedef bool (*ReportFunction)(int32_t value); // Sets the local attribute and reports it
+
+    ZigbeePublisher();
+
+    // `apply` may be nullptr for attributes that are always reported when they change.
+    // Values within the same multiple of `resolution` count as unchanged.
+    void attach(ZigbeeAttribute attribute, ApplyFunction apply, ReportFunction report, int32_t resolution, uint32_t minIntervalMs, bool persistent);
+    // `immediate` skips the attribute's minimum interval, e.g. for the last value of a burst.
+    void set(ZigbeeAttribute attribute, int32_t value, bool immediate = false);
+    // Treats `value` as already known to the coordinator without sending it, e.g. because the
+    // coordinator just wrote it. Drops any report of an older value still waiting to be sent.
+    void assumePublished(ZigbeeAttribute attribute, int32_t value);
+    // Holds every report back until `nowMs`, so a room of blinds booting together spreads out.
+    void holdUntil(uint32_t nowMs);
+
+    // Sends due reports. Returns true when the coordinator's view of a persistent attribute changed
+    // (published or assumed) and the snapshot should be saved.
+    bool flush(uint32_t nowMs);
+    bool hasPending() const;
+    uint32_t getFramesSent() const
+    {
+        return framesSent;
+    }
+
+    ZigbeePublishedSnapshot snapshot() const;
+    bool restore(const ZigbeePublishedSnapshot &snapshot);
+
+private:
+    struct Slot
+    {
+        ApplyFunction apply;
+        ReportFunction report;
+        int32_t resolution;
+        uint32_t minIntervalMs;
+        bool persistent;
+        bool applyPending; // The local attribute does not hold `pending` yet
+        bool dirty;        // `pending` has not been reported yet
+        bool immediate;
+        bool published;
+        int32_t pending;
+        int32_t lastPublished;
+        uint32_t lastPublishMs;
+        uint32_t revision; // Bumped on every update, to spot one made while the slot was being sent
+    };
+
+    bool sameValue(const Slot &slot, int32_t a, int32_t b) const;
+
+    Slot slots[ZB_ATTR_COUNT];
+    uint32_t holdUntilMs;
+    uint32_t framesSent;
+    bool snapshotChanged; // A persistent attribute was assumed published since the last flush
+    mutable portMUX_TYPE lock;
+};
@@ -0,0 +1,227 @@
+#include "SerialCommand.h"
+#include "ZigbeeCoveringHelper.h"
+#include <stdarg.h>
+
+SerialCommand::SerialCommand(Stream &stream, StepperUart &motor)
+    : stream(stream), motor(motor), length(0), overflow(false), wasRunning(false), commandCount(0), errorCount(0), overflowCount(0)
+{
+}
+
+void SerialCommand::poll()
+{
+    for (int i = 0; i < SERIAL_COMMAND_MAX_BYTES_PER_POLL && stream.available() > 0; i++)
+    {
+        int c = stream.read();
+        if (c < 0)
+            break;
+        if (c == '\r')
+            continue;
+
+        if (c == '\n')
+        {
+            if (overflow)
+            {
+                overflowCount++;
+                reply("-", "err", "line too long");
+            }
+            else
+            {
+                buffer[length] = '\0';
+                handleLine(buffer);
+            }
+            length = 0;
+            overflow = false;
+        }
+        else if (length < SERIAL_COMMAND_MAX_LINE - 1)
+        {
+            buffer[length++] = static_cast<char>(c);
+        }
+        else
+        {
+            overflow = true; // Drop the rest of the line
+        }
+    }
+
+    // Report when a cover move finishes (after any back-off) so a host can time it without polling
+    bool running = isCoverMoving();
+    if (wasRunning && !running)
+    {
+        CoverState state = getCoverState();
+        reply("-", "evt", "stopped pos=%ld lift=%.1f", static_cast<long>(state.position), state.liftPercentage);
+    }
+    wasRunning = running;
+}
+
+void SerialCommand::handleLine(char *line)
+{
+    while (*line == ' ' || *line == '\t')
+        line++;
+
+    const char *tag = "-";
+    if (*line == '#')
+    {
+        tag = line;
+        while (*line != '\0' && *line != ' ' && *line != '\t')
+            line++;
+        if (*line != '\0')
+            *line++ = '\0';
+    }
+
+    char *savePtr = nullptr;
+    for (char *command = strtok_r(line, ";", &savePtr); command != nullptr; command = strtok_r(nullptr, ";", &savePtr))
+    {
+        execute(tag, command);
+    }
+}
+
+void SerialCommand::execute(const char *tag, char *command)
+{
+    char *savePtr = nullptr;
+    const char *name = strtok_r(command, " \t", &savePtr);
+    if (name == nullptr)
+        return;
+    const char *arg = strtok_r(nullptr, " \t", &savePtr);
+    commandCount++;
+    if (strtok_r(nullptr, " \t", &savePtr) != nullptr)
+    {
+        errorCount++;
+        reply(tag, "err", "too many arguments");
+        return;
+    }
+
+    long value = 0;
+
+    if (strcmp(name, "open") == 0 || strcmp(name, "o") == 0)
+    {
+        openCover();
+        reply(tag, "ok");
+    }
+    else if (strcmp(name, "close") == 0 || strcmp(name, "c") == 0)
+    {
+        closeCover();
+        reply(tag, "ok");
+    }
+    else if (strcmp(name, "stop") == 0 || strcmp(name, "s") == 0)
+    {
+        stopCover();
+        reply(tag, "ok");
+    }
+    else if (strcmp(name, "home") == 0 || strcmp(name, "h") == 0)
+    {
+        startHoming(); // Runs in its own task; stop aborts it
+        reply(tag, "ok");
+    }
+    else if (strcmp(name, "goto") == 0)
+    {
+        if (!parseArgument(tag, arg, 0, 100, value))
+            return;
+        goToLiftPercentage(static_cast<uint8_t>(value));
+        reply(tag, "ok", "target=%ld", static_cast<long>(getCoverState().targetPosition));
+    }
+    else if (strcmp(name, "speed") == 0)
+    {
+        if (!parseArgument(tag, arg, 1, ActiveHardware::MAX_SPEED, value))
+            return;
+        setCoverSpeed(static_cast<float>(value));
+        reply(tag, "ok");
+    }
+    else if (name[0] >= '1' && name[0] <= '5' && name[1] == '\0' && arg == nullptr)
+    {
+        // Speed presets of the old single-character interface
+        static const uint32_t presets[] = {1000, 2400, 5000, 7500, 10000};
+        uint32_t speed = presets[name[0] - '1'];
+        setCoverSpeed(static_cast<float>(speed));
+        reply(tag, "ok", "speed=%lu", static_cast<unsigned long>(speed));
+    }
+    else if ((strcmp(name, "+") == 0 || strcmp(name, "-") == 0) && arg == nullptr)
+    {
+        // Stall sensitivity steps of the old single-character interface
+        int sgthrs = motor.getSGTHRS() + (name[0] == '+' ? 10 : -10);
+        sgthrs = constrain(sgthrs, 0, 144);
+        setCoverStallSensitivity(static_cast<uint8_t>(sgthrs));
+        reply(tag, "ok", "sgthrs=%d", sgthrs);
+    }
+    else if (strcmp(name, "sgthrs") == 0)
+    {
+        if (!parseArgument(tag, arg, 0, 144, value))
+            return;
+        setCoverStallSensitivity(static_cast<uint8_t>(value));
+        reply(tag, "ok");
+    }
+    else if (strcmp(name, "top") == 0)
+    {
+        if (!parseArgument(tag, arg, 0, ActiveHardware::MAX_LIMIT_CM, value))
+            return;
+        setCoverTopLimit(static_cast<uint16_t>(value));
+        reply(tag, "ok");
+    }
+    else if (strcmp(name, "bottom") == 0)
+    {
+        if (!parseArgument(tag, arg, 0, ActiveHardware::MAX_LIMIT_CM, value))
+            return;
+        setCoverBottomLimit(static_cast<uint16_t>(value));
+        reply(tag, "ok");
+    }
+    else if (strcmp(name, "state") == 0)
+    {
+        CoverState state = getCoverState();
+        reply(tag, "ok", "pos=%ld target=%ld running=%d lift=%.1f top=%u bottom=%u speed=%.0f sgthrs=%u eta=%lu",
+              static_cast<long>(state.position), static_cast<long>(state.targetPosition), state.running ? 1 : 0,
+              state.liftPercentage, state.topLimit, state.bottomLimit, state.speed, state.stallSensitivity,
+              static_cast<unsigned long>(state.etaMs));
+    }
+    else if (strcmp(name, "travel") == 0)
+    {
+        const TravelModel &model = getTravelModel();
+        const TravelErrorStats &up = model.getErrorStats(TRAVEL_UP);
+        const TravelErrorStats &down = model.getErrorStats(TRAVEL_DOWN);
+        reply(tag, "ok", "eta=%lu predicted=%ld up_n=%lu up_mae=%.0f up_bias=%.0f up_max=%.0f down_n=%lu down_mae=%.0f down_bias=%.0f down_max=%.0f",
+              static_cast<unsigned long>(model.remainingMs(millis())), static_cast<long>(model.predictedPosition(millis())),
+              static_cast<unsigned long>(up.trips), up.meanAbsErrorMs, up.meanErrorMs, up.maxAbsErrorMs,
+              static_cast<unsigned long>(down.trips), down.meanAbsErrorMs, down.meanErrorMs, down.maxAbsErrorMs);
+    }
+    else if (strcmp(name, "metrics") == 0)
+    {
+        reply(tag, "ok", "uptime=%lu heap=%lu minheap=%lu cmds=%lu errs=%lu overflows=%lu",
+              static_cast<unsigned long>(millis()), static_cast<unsigned long>(ESP.getFreeHeap()),
+              static_cast<unsigned long>(ESP.getMinFreeHeap()), static_cast<unsigned long>(commandCount),
+              static_cast<unsigned long>(errorCount), static_cast<unsigned long>(overflowCount));
+    }
+    else if (strcmp(name, "ping") == 0)
+    {
+        reply(tag, "ok");
+    }
+    else
+    {
+        errorCount++;
+        reply(tag, "err", "unknown command");
+    }
+}
+
+bool SerialCommand::parseArgument(const char *tag, const char *arg, long min, long max, long &value)
+{
+    char *end = nullptr;
+    if (arg != nullptr)
+        value = strtol(arg, &end, 10);
+
+    if (arg == nullptr || end == arg || *end != '\0' || value < min || value > max)
+    {
+        errorCount++;
+        reply(tag, "err", "expected %ld-%ld", min, max);
+        return false;
+    }
+    return true;
+}
+
+void SerialCommand::reply(const char *tag, const char *status, const char *format, ...)
+{
+    char payload[SERIAL_COMMAND_MAX_REPLY] = "";
+    if (format != nullptr)
+    {
+        va_list args;
+        va_start(args, format);
+        vsnprintf(payload, sizeof(payload), format, args);
+        va_end(args);
+    }
+    stream.printf("%lu %s %s%s%s\n", static_cast<unsigned long>(millis()), tag, status, payload[0] ? " " : "", payload);
+}
@@ -2,15 +2,17 @@
 
 int lastUpdate = -1;
 
-StepperUart::StepperUart(int dirPin, int stepPin, int enablePin)
-    : engine(), enablePin(enablePin), stepPin(stepPin), dirPin(dirPin), targetPosition(0), speed(5000), motorEnabled(false), positionUpdateCallback(nullptr)
+template <typename Profile>
+BasicStepperUart<Profile>::BasicStepperUart()
+    : engine(), targetPosition(0), speed(5000), motorEnabled(false), positionUpdateCallback(nullptr)
 {
     engine.init();
 }
 
+template <typename Profile>
 void vUpdatePositionTask(TimerHandle_t xTimer)
 {
-    StepperUart *stepper = static_cast<StepperUart *>(pvTimerGetTimerID(xTimer));
+    BasicStepperUart<Profile> *stepper = static_cast<BasicStepperUart<Profile> *>(pvTimerGetTimerID(xTimer));
     int32_t currentPosition = stepper->getCurrentPosition();
 
     if (currentPosition == lastUpdate)
@@ -25,9 +27,10 @@ void vUpdatePositionTask(TimerHandle_t xTimer)
     }
 }
 
+template <typename Profile>
 void vStallDetectTask(TimerHandle_t xTimer)
 {
-    StepperUart *stepper = static_cast<StepperUart *>(pvTimerGetTimerID(xTimer));
+    BasicStepperUart<Profile> *stepper = static_cast<BasicStepperUart<Profile> *>(pvTimerGetTimerID(xTimer));
 
     TMC2209Stepper driver = stepper->getDriver();
     if (driver.diag())
@@ -41,25 +44,27 @@ void vStallDetectTask(TimerHandle_t xTimer)
     //     Serial.printf("TSTEP: %d, SG: %d, SGTHRS: %d\n", driver.TSTEP(), driver.SG_RESULT(), driver.SGTHRS());
 }
 
-void StepperUart::init()
+template <typename Profile>
+void BasicStepperUart<Profile>::init()
 {
-    pinMode(enablePin, OUTPUT);
+    pinMode(Profile::ENABLE_PIN, OUTPUT);
     disableMotor(); // Disable the motor initially
 
     HWSerial.begin(115200);
 
-    _stepper = engine.stepperConnectToPin(stepPin);
-    _stepper->setDirectionPin(dirPin);
-    _stepper->setEnablePin(enablePin, true);
+    _stepper = engine.stepperConnectToPin(Profile::STEP_PIN);
+    _stepper->setDirectionPin(Profile::DIR_PIN);
+    _stepper->setEnablePin(Profile::ENABLE_PIN, true);
     _stepper->setAutoEnable(true);
     _stepper->setDelayToDisable(1000);
     _stepper->setSpeedInHz(speed);
     _stepper->setAcceleration(1e6);
 
-    driver.begin();           // SPI: Init CS pins and possible SW SPI pins
-    driver.rms_current(1500); // Set motor RMS current
+    driver.begin();                              // SPI: Init CS pins and possible SW SPI pins
+    driver.rms_current(Profile::RMS_CURRENT_MA); // Set motor RMS current
+    driver.microsteps(Profile::MICROSTEPS);
 
-    setSpeed(speed, 8); // Set speed and microsteps
+    setSpeed(speed);
 
     driver.pwm_autoscale(true); // Needed for stealthChop
     driver.pwm_autograd(true);
@@ -67,60 +72,69 @@ void StepperUart::init()
     // driver.semin(0); // disable coolstep
 
     TimerHandle_t updateTimer = xTimerCreate(
-        "UpdateTask",        // Timer name
-        pdMS_TO_TICKS(1000), // Timer interval
-        pdTRUE,              // Auto-reload
-        this,                // pass the stepper instance to the task
-        vUpdatePositionTask  // Callback function
+        "UpdateTask",                // Timer name
+        pdMS_TO_TICKS(1000),         // Timer interval
+        pdTRUE,                      // Auto-reload
+        this,                        // pass the stepper instance to the task
+        vUpdatePositionTask<Profile> // Callback function
     );
     xTimerStart(updateTimer, 0); // Start the timer
 
     TimerHandle_t stallTask = xTimerCreate(
-        "StepperTask",    // Timer name
-        pdMS_TO_TICKS(5), // Timer interval
-        pdTRUE,           // Auto-reload
-        this,             // pass the stepper instance to the task
-        vStallDetectTask  // Callback function
+        "StepperTask",            // Timer name
+        pdMS_TO_TICKS(5),         // Timer interval
+        pdTRUE,                   // Auto-reload
+        this,                     // pass the stepper instance to the task
+        vStallDetectTask<Profile> // Callback function
     );
     xTimerStart(stallTask, 0); // Start the timer
 }
 
-void StepperUart::setSpeed(float speed, int microsteps)
+template <typename Profile>
+void BasicStepperUart<Profile>::setSpeed(uint32_t speed)
 {
-    driver.microsteps(microsteps);
+    if (speed < 1)
+        speed = 1;
+    if (speed > Profile::MAX_SPEED)
+        speed = Profile::MAX_SPEED;
 
-    // Calculate TSTEP based on speed and microsteps, 12MHz clock
-    // TSTEP = (12MHz / (speed * microsteps))
-    int tstep = (12000000 / (speed / microsteps * 256)) + 1;
-    driver.TCOOLTHRS(tstep * 1.3); // Set TCOOLTHRS to slighty above nominal speed to disable stallguard and coolstep when decelerating
-    printf("TSTEP: %d, TCOOLTHRS: %d\n", tstep, driver.TCOOLTHRS());
+    // TSTEP at this speed and the profile's microstepping; the clock scale is a compile-time constant
+    uint32_t tstep = Profile::tstep(speed);
+    driver.TCOOLTHRS(Profile::tcoolthrs(speed)); // Set TCOOLTHRS to slighty above nominal speed to disable stallguard and coolstep when decelerating
+    printf("TSTEP: %lu, TCOOLTHRS: %lu\n", static_cast<unsigned long>(tstep), static_cast<unsigned long>(driver.TCOOLTHRS()));
 
     this->speed = speed;
     _stepper->setSpeedInHz(speed);
 }
-void StepperUart::setSGTHRS(uint8_t threshold)
+template <typename Profile>
+void BasicStepperUart<Profile>::setSGTHRS(uint8_t threshold)
 {
     driver.SGTHRS(threshold);
     Serial.printf("SGTHRS set to: %d\n", threshold);
 }
-void StepperUart::moveTo(int32_t position)
+template <typename Profile>
+void BasicStepperUart<Profile>::moveTo(int32_t position)
 {
     targetPosition = position;
     _stepper->moveTo(position);
 }
-void StepperUart::stop()
+template <typename Profile>
+void BasicStepperUart<Profile>::stop()
 {
     _stepper->stopMove();
 }
-void StepperUart::forceStop()
+template <typename Profile>
+void BasicStepperUart<Profile>::forceStop()
 {
     _stepper->forceStop();
 }
-int32_t StepperUart::getCurrentPosition()
+template <typename Profile>
+int32_t BasicStepperUart<Profile>::getCurrentPosition()
 {
     return _stepper->getCurrentPosition();
 }
-void StepperUart::setCurrentPosition(int32_t position)
+template <typename Profile>
+void BasicStepperUart<Profile>::setCurrentPosition(int32_t position)
 {
     _stepper->setCurrentPosition(position);
     lastUpdate = position;
@@ -129,7 +143,10 @@ void StepperUart::setCurrentPosition(int32_t position)
         this->positionUpdateCallback(position);
     }
 }
-bool StepperUart::isRunning()
+template <typename Profile>
+bool BasicStepperUart<Profile>::isRunning()
 {
     return _stepper->isRunning();
-}
\ No newline at end of file
+}
+
+template class BasicStepperUart<ActiveHardware>;
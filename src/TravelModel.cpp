@@ -0,0 +1,286 @@
+#include "TravelModel.h"
+#include <algorithm>
+
+static const float MIN_EFFICIENCY = 0.05f;
+static const float MAX_EFFICIENCY = 2.0f;
+static const float MAX_OVERHEAD_MS = 60000.0f;
+
+TravelModel::TravelModel()
+    : rangeTop(0), rangeBottom(0), tripActive(false), tripDirection(TRAVEL_DOWN), tripFrom(0), tripTo(0), tripSpeed(0),
+      tripStartMs(0), tripPredictedMs(0), anchorMs(0), anchorPosition(0), anchorPredictedMs(0), anchorIncludesOverhead(true),
+      lastSampleMs(0), lastSamplePosition(0), lastSampleRunning(false)
+{
+    reset();
+}
+
+void TravelModel::reset()
+{
+    params.version = TRAVEL_MODEL_VERSION;
+    for (int direction = 0; direction < 2; direction++)
+    {
+        for (int bin = 0; bin < TRAVEL_MODEL_BINS; bin++)
+            params.efficiency[direction][bin] = 1.0f;
+        params.overheadMs[direction] = 0.0f;
+        stats[direction] = TravelErrorStats{};
+    }
+    tripActive = false;
+}
+
+void TravelModel::setRange(int32_t topPosition, int32_t bottomPosition)
+{
+    rangeTop = topPosition;
+    rangeBottom = bottomPosition;
+}
+
+bool TravelModel::setParams(const TravelModelParams &newParams)
+{
+    if (newParams.version != TRAVEL_MODEL_VERSION)
+        return false;
+    for (int direction = 0; direction < 2; direction++)
+    {
+        for (int bin = 0; bin < TRAVEL_MODEL_BINS; bin++)
+        {
+            float efficiency = newParams.efficiency[direction][bin];
+            if (!(efficiency >= MIN_EFFICIENCY && efficiency <= MAX_EFFICIENCY))
+                return false;
+        }
+        float overhead = newParams.overheadMs[direction];
+        if (!(overhead >= 0.0f && overhead <= MAX_OVERHEAD_MS))
+            return false;
+    }
+    params = newParams;
+    return true;
+}
+
+TravelModelStats TravelModel::getStats() const
+{
+    TravelModelStats saved;
+    saved.version = TRAVEL_STATS_VERSION;
+    saved.direction[TRAVEL_UP] = stats[TRAVEL_UP];
+    saved.direction[TRAVEL_DOWN] = stats[TRAVEL_DOWN];
+    return saved;
+}
+
+bool TravelModel::setStats(const TravelModelStats &newStats)
+{
+    if (newStats.version != TRAVEL_STATS_VERSION)
+        return false;
+    for (int direction = 0; direction < 2; direction++)
+    {
+        // The running means may drift past each other by rounding, hence the 1 ms slack
+        const TravelErrorStats &s = newStats.direction[direction];
+        if (!(s.maxAbsErrorMs >= 0.0f && s.maxAbsErrorMs <= UINT32_MAX))
+            return false;
+        if (!(s.meanAbsErrorMs >= 0.0f && s.meanAbsErrorMs <= s.maxAbsErrorMs + 1.0f))
+            return false;
+        if (!(fabsf(s.meanErrorMs) <= s.meanAbsErrorMs + 1.0f))
+            return false;
+    }
+    stats[TRAVEL_UP] = newStats.direction[TRAVEL_UP];
+    stats[TRAVEL_DOWN] = newStats.direction[TRAVEL_DOWN];
+    return true;
+}
+
+int TravelModel::binOf(int32_t position) const
+{
+    int64_t span = static_cast<int64_t>(rangeBottom) - rangeTop;
+    if (span <= 0)
+        return 0;
+    int64_t bin = (static_cast<int64_t>(position) - rangeTop) * TRAVEL_MODEL_BINS / span;
+    if (position < rangeTop)
+        return 0;
+    return bin >= TRAVEL_MODEL_BINS ? TRAVEL_MODEL_BINS - 1 : static_cast<int>(bin);
+}
+
+// Bin edges; the outer bins extend past the limits
+int64_t TravelModel::binLowerEdge(int bin) const
+{
+    if (bin == 0)
+        return INT64_MIN;
+    int64_t span = static_cast<int64_t>(rangeBottom) - rangeTop;
+    // Smallest position that falls in this bin
+    return rangeTop + (bin * span + TRAVEL_MODEL_BINS - 1) / TRAVEL_MODEL_BINS;
+}
+
+int64_t TravelModel::binUpperEdge(int bin) const
+{
+    if (bin == TRAVEL_MODEL_BINS - 1 || rangeBottom <= rangeTop)
+        return INT64_MAX;
+    return binLowerEdge(bin + 1);
+}
+
+// Walks from `from` towards `to` through the position bins until `budgetMs` is used up. Returns the
+// time spent and stores where the walk ended in `reached`.
+float TravelModel::travel(int32_t from, int32_t to, float speed, float budgetMs, int32_t &reached) const
+{
+    TravelDirection direction = to < from ? TRAVEL_UP : TRAVEL_DOWN;
+    int step = to < from ? -1 : 1;
+    if (speed < 1.0f)
+        speed = 1.0f;
+
+    float elapsed = 0.0f;
+    int32_t position = from;
+    while (position != to)
+    {
+        int bin = binOf(step > 0 ? position : position - 1);
+        int64_t edge = step > 0 ? binUpperEdge(bin) : binLowerEdge(bin);
+        int32_t segmentEnd = step > 0 ? static_cast<int32_t>(edge < to ? edge : to) : static_cast<int32_t>(edge > to ? edge : to);
+
+        float stepsPerMs = speed * params.efficiency[direction][bin] / 1000.0f;
+        float segmentMs = abs(segmentEnd - position) / stepsPerMs;
+        if (elapsed + segmentMs >= budgetMs)
+        {
+            reached = position + step * static_cast<int32_t>((budgetMs - elapsed) * stepsPerMs);
+            return budgetMs;
+        }
+        elapsed += segmentMs;
+        position = segmentEnd;
+    }
+    reached = to;
+    return elapsed;
+}
+
+uint32_t TravelModel::predictDurationMs(int32_t from, int32_t to, float speed) const
+{
+    if (from == to)
+        return 0;
+    TravelDirection direction = to < from ? TRAVEL_UP : TRAVEL_DOWN;
+    int32_t reached;
+    float motionMs = travel(from, to, speed, INFINITY, reached);
+    return static_cast<uint32_t>(params.overheadMs[direction] + motionMs + 0.5f);
+}
+
+int32_t TravelModel::predictPosition(int32_t from, int32_t to, float speed, uint32_t elapsedMs) const
+{
+    if (from == to)
+        return to;
+    TravelDirection direction = to < from ? TRAVEL_UP : TRAVEL_DOWN;
+    float overhead = params.overheadMs[direction];
+    if (elapsedMs <= overhead)
+        return from;
+    int32_t reached;
+    travel(from, to, speed, elapsedMs - overhead, reached);
+    return reached;
+}
+
+void TravelModel::beginTrip(uint32_t nowMs, int32_t from, int32_t to, float speed)
+{
+    tripActive = from != to;
+    tripDirection = to < from ? TRAVEL_UP : TRAVEL_DOWN;
+    tripFrom = from;
+    tripTo = to;
+    tripSpeed = speed;
+    tripStartMs = nowMs;
+    tripPredictedMs = predictDurationMs(from, to, speed);
+
+    anchorMs = nowMs;
+    anchorPosition = from;
+    anchorPredictedMs = tripPredictedMs;
+    anchorIncludesOverhead = true;
+
+    lastSampleMs = nowMs;
+    lastSamplePosition = from;
+    lastSampleRunning = false;
+}
+
+void TravelModel::cancelTrip()
+{
+    tripActive = false;
+}
+
+void TravelModel::replan(uint32_t nowMs, int32_t position)
+{
+    if (!tripActive)
+        return;
+    int32_t reached;
+    anchorMs = nowMs;
+    anchorPosition = position;
+    anchorPredictedMs = static_cast<uint32_t>(travel(position, tripTo, tripSpeed, INFINITY, reached) + 0.5f);
+    anchorIncludesOverhead = false;
+}
+
+uint32_t TravelModel::remainingMs(uint32_t nowMs) const
+{
+    if (!tripActive)
+        return 0;
+    uint32_t elapsed = nowMs - anchorMs;
+    return elapsed >= anchorPredictedMs ? 0 : anchorPredictedMs - elapsed;
+}
+
+uint32_t TravelModel::overdueMs(uint32_t nowMs) const
+{
+    if (!tripActive)
+        return 0;
+    uint32_t elapsed = nowMs - anchorMs;
+    return elapsed <= anchorPredictedMs ? 0 : elapsed - anchorPredictedMs;
+}
+
+int32_t TravelModel::predictedPosition(uint32_t nowMs) const
+{
+    if (!tripActive)
+        return lastSamplePosition;
+    uint32_t elapsed = nowMs - anchorMs;
+    if (anchorIncludesOverhead)
+        return predictPosition(anchorPosition, tripTo, tripSpeed, elapsed);
+    int32_t reached;
+    travel(anchorPosition, tripTo, tripSpeed, elapsed, reached);
+    return reached;
+}
+
+bool TravelModel::sample(uint32_t nowMs, int32_t position, bool running)
+{
+    if (!tripActive)
+        return false;
+
+    uint32_t window = nowMs - lastSampleMs;
+    if (window >= TRAVEL_MODEL_MIN_SAMPLE_MS)
+    {
+        int32_t lo = std::min(tripFrom, tripTo);
+        int32_t hi = std::max(tripFrom, tripTo);
+        int32_t moved = position - lastSamplePosition;
+        bool forward = tripDirection == TRAVEL_UP ? moved < 0 : moved > 0;
+        bool inside = position >= lo && position <= hi && lastSamplePosition >= lo && lastSamplePosition <= hi;
+
+        // Only learn from windows of steady motion within the trip, not start-up or back-off
+        if (running && lastSampleRunning && forward && inside)
+        {
+            float observed = abs(moved) * 1000.0f / window / tripSpeed;
+            int bin = binOf(lastSamplePosition + moved / 2);
+            float &efficiency = params.efficiency[tripDirection][bin];
+            efficiency += TRAVEL_MODEL_LEARNING_RATE * (observed - efficiency);
+            efficiency = std::min(std::max(efficiency, MIN_EFFICIENCY), MAX_EFFICIENCY);
+        }
+
+        lastSampleMs = nowMs;
+        lastSamplePosition = position;
+        lastSampleRunning = running;
+    }
+
+    if (!running && abs(position - tripTo) <= TRAVEL_MODEL_ARRIVAL_TOLERANCE)
+    {
+        recordArrival(nowMs);
+        return true;
+    }
+    return false;
+}
+
+void TravelModel::recordArrival(uint32_t nowMs)
+{
+    float actualMs = nowMs - tripStartMs;
+    float errorMs = actualMs - static_cast<float>(tripPredictedMs);
+
+    TravelErrorStats &s = stats[tripDirection];
+    s.trips++;
+    s.meanErrorMs += (errorMs - s.meanErrorMs) / s.trips;
+    s.meanAbsErrorMs += (fabsf(errorMs) - s.meanAbsErrorMs) / s.trips;
+    s.maxAbsErrorMs = std::max(s.maxAbsErrorMs, fabsf(errorMs));
+
+    // Whatever the bins do not explain is start-up and back-off overhead
+    int32_t reached;
+    float motionMs = travel(tripFrom, tripTo, tripSpeed, INFINITY, reached);
+    float &overhead = params.overheadMs[tripDirection];
+    overhead += TRAVEL_MODEL_LEARNING_RATE * ((actualMs - motionMs) - overhead);
+    overhead = std::min(std::max(overhead, 0.0f), MAX_OVERHEAD_MS);
+
+    tripActive = false;
+}
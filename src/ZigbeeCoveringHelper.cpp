@@ -1,34 +1,93 @@
 #include "ZigbeeCoveringHelper.h"
+#include "ZigbeePublisher.h"
 #include <ZigbeeCore.h>
 #include <ep/ZigbeeWindowCovering.h>
 #include <ep/ZigbeeAnalog.h>
 #include <Preferences.h>
+#include <atomic>
 
 static ZigbeeWindowCovering *zbCovering = nullptr;
 static ZigbeeAnalog *zbAnalogStallSensitivity = nullptr;
 static ZigbeeAnalog *zbAnalogBottomLimit = nullptr;
 static ZigbeeAnalog *zbAnalogTopLimit = nullptr;
 static ZigbeeAnalog *zbAnalogSpeed = nullptr;
+static ZigbeeAnalog *zbAnalogEta = nullptr;
 static StepperUart *stepperMotor = nullptr;
 
 static Preferences prefs;
+static TravelModel travelModel;
+static ZigbeePublisher zbPublisher;
 
 static uint16_t BOTTOM_LIMIT = -1; // Bottom limit in cm
 static uint16_t TOP_LIMIT = -1;    // Top limit in cm
 
-// 2.0cm diameter spool, 200 steps per round x 8 microsteps x 4.666666666666:1 gear ratio (~ 1188)
-const uint32_t STEPS_PER_CM = (200 * 8 * 4.667) / (2.0 * PI);
+// Spool, gearbox and microstepping of the active hardware profile
+constexpr uint32_t STEPS_PER_CM = ActiveHardware::STEPS_PER_CM;
 
 // Because the tension in the string is high when lifting the cover, we overshoot the target a bit
 // and then move back down to the target position.
-const uint32_t liftBackOff = 0.3 * STEPS_PER_CM; // how much we initially overshoot the target when moving up
+constexpr uint32_t liftBackOff = STEPS_PER_CM * 3 / 10; // how much we initially overshoot the target when moving up (0.3 cm)
+
+const uint32_t TRAVEL_SAMPLE_INTERVAL_MS = 100;
+const uint32_t TRAVEL_ETA_REPUBLISH_MS = 2000; // Republish the ETA when the blind drifts this far from the prediction
+const uint32_t TRAVEL_TRIP_TIMEOUT_MS = 5000;  // Give up on a trip that stopped short of its target
+const uint32_t TRAVEL_MODEL_SAVE_MS = 60000;   // Save the learned model and its stats at most this often
 
 static boolean flag_init = false;
+static bool flag_homing = false;
+static bool flag_homingAborted = false;
+
+static int32_t coverTarget = 0;     // Final position of the current or last cover move
+// Tasks that will still command the motor (back-off, homing). Changed from the Zigbee task, loop()
+// and the move tasks themselves, hence atomic.
+static std::atomic<uint8_t> activeMoveTasks{0};
+
+// Move tasks count as part of the cover move until they end, so the move is not reported finished
+// while the motor pauses between an overshoot and its back-off.
+static bool startMoveTask(TaskFunction_t task, const char *name)
+{
+    // Counted before the task exists so it cannot end first, and uncounted again if it never starts
+    activeMoveTasks++;
+    if (xTaskCreate(task, name, 2048, nullptr, 1, nullptr) != pdPASS)
+    {
+        activeMoveTasks--;
+        Serial.printf("Failed to start %s\n", name);
+        return false;
+    }
+    return true;
+}
+
+static void endMoveTask()
+{
+    activeMoveTasks--;
+    vTaskDelete(NULL);
+}
+
+// Lift in hundredths of a percent, 0 at the top limit and 10000 at the bottom limit. Outside that
+// range when the blind is beyond the limits.
+static int32_t liftBasisPointsAt(int32_t position)
+{
+    int64_t top = static_cast<int64_t>(TOP_LIMIT) * STEPS_PER_CM;
+    int64_t span = (static_cast<int64_t>(BOTTOM_LIMIT) - TOP_LIMIT) * STEPS_PER_CM;
+    if (span == 0)
+        return 0;
+    return static_cast<int32_t>((position - top) * 10000 / span);
+}
+
+static float liftPercentageAt(int32_t position)
+{
+    return liftBasisPointsAt(position) / 100.0f;
+}
+
+// Whole percent within the limits, as reported to Zigbee
+static uint8_t liftPercentageClamped(int32_t position)
+{
+    return static_cast<uint8_t>((constrain(liftBasisPointsAt(position), 0, 10000) + 50) / 100);
+}
 
 void updatePosition(int32_t currentPosition)
 {
-    float currentLift = 1.0 * currentPosition / STEPS_PER_CM - TOP_LIMIT;
-    float currentLiftPercentage = (currentLift * 100.0) / (1.0 * BOTTOM_LIMIT - TOP_LIMIT);
+    uint8_t currentLiftPercentage = liftPercentageClamped(currentPosition);
 
     prefs.begin("ZBCover");
     int32_t savedPosition = prefs.getInt("currentPosition", 0);
@@ -39,19 +98,172 @@ void updatePosition(int32_t currentPosition)
     }
 
     prefs.putInt("currentPosition", static_cast<int32_t>(currentPosition));
-    Serial.printf("Saved lift position: %d (%.2f%%).\n", currentPosition, currentLiftPercentage);
+    Serial.printf("Saved lift position: %d (%d%%).\n", currentPosition, currentLiftPercentage);
+
+    prefs.end();
+
+    // Progress is rate limited while the cover moves, the position it settles at goes out right away
+    zbPublisher.set(ZB_ATTR_LIFT_PERCENTAGE, currentLiftPercentage, !isCoverMoving());
+}
+
+static void publishEta(uint32_t etaMs)
+{
+    zbPublisher.set(ZB_ATTR_ETA, static_cast<int32_t>(etaMs));
+}
+
+static bool reportLiftPercentage(int32_t value)
+{
+    return Zigbee.started() && zbCovering != nullptr && zbCovering->setLiftPercentage(static_cast<uint8_t>(value));
+}
+
+static bool applyAnalogOutput(ZigbeeAnalog *endpoint, int32_t value)
+{
+    return Zigbee.started() && endpoint != nullptr && endpoint->setAnalogOutput(static_cast<float>(value));
+}
+
+static bool reportAnalogOutput(ZigbeeAnalog *endpoint, int32_t value)
+{
+    return applyAnalogOutput(endpoint, value) && endpoint->reportAnalogOutput();
+}
+
+static bool applyStallSensitivity(int32_t value)
+{
+    return applyAnalogOutput(zbAnalogStallSensitivity, value);
+}
+
+static bool reportStallSensitivity(int32_t value)
+{
+    return reportAnalogOutput(zbAnalogStallSensitivity, value);
+}
+
+static bool applyBottomLimit(int32_t value)
+{
+    return applyAnalogOutput(zbAnalogBottomLimit, value);
+}
+
+static bool reportBottomLimit(int32_t value)
+{
+    return reportAnalogOutput(zbAnalogBottomLimit, value);
+}
+
+static bool applyTopLimit(int32_t value)
+{
+    return applyAnalogOutput(zbAnalogTopLimit, value);
+}
+
+static bool reportTopLimit(int32_t value)
+{
+    return reportAnalogOutput(zbAnalogTopLimit, value);
+}
+
+static bool applySpeed(int32_t value)
+{
+    return applyAnalogOutput(zbAnalogSpeed, value);
+}
+
+static bool reportSpeed(int32_t value)
+{
+    return reportAnalogOutput(zbAnalogSpeed, value);
+}
+
+static bool reportEta(int32_t etaMs)
+{
+    return Zigbee.started() && zbAnalogEta != nullptr && zbAnalogEta->setAnalogInput(etaMs / 1000.0f) &&
+           zbAnalogEta->reportAnalogInput();
+}
+
+void vZigbeePublishTask(TimerHandle_t)
+{
+    if (!zbPublisher.flush(millis()))
+        return;
 
+    // Remember what the coordinator has, so the next boot only sends what changed
+    ZigbeePublishedSnapshot snapshot = zbPublisher.snapshot();
+    prefs.begin("ZBCover");
+    prefs.putBytes("zbPublished", &snapshot, sizeof(snapshot));
     prefs.end();
+}
 
-    if (!Zigbee.started() || zbCovering == nullptr)
+static void beginTravel(int32_t target)
+{
+    coverTarget = target;
+    if (stepperMotor == nullptr)
         return;
+    travelModel.setRange(TOP_LIMIT * STEPS_PER_CM, BOTTOM_LIMIT * STEPS_PER_CM);
+    travelModel.beginTrip(millis(), stepperMotor->getCurrentPosition(), target, stepperMotor->getSpeed());
+    uint32_t etaMs = travelModel.remainingMs(millis());
+    Serial.printf("Predicted travel time: %lu ms\n", static_cast<unsigned long>(etaMs));
+    publishEta(etaMs);
+}
 
-    if (currentLiftPercentage > 100)
-        zbCovering->setLiftPercentage(100);
-    else if (currentLiftPercentage < 0)
-        zbCovering->setLiftPercentage(0);
-    else
-        zbCovering->setLiftPercentage(currentLiftPercentage);
+static void cancelTravel()
+{
+    if (!travelModel.isTripActive())
+        return;
+    travelModel.cancelTrip();
+    publishEta(0);
+}
+
+static bool travelModelPending = false;
+static uint32_t lastTravelModelSave = 0;
+
+// Writes the learned params and the error stats if a trip changed them and the last write was long
+// enough ago. Both change on every trip, so a burst of moves costs one write per interval, and a
+// power cut loses at most TRAVEL_MODEL_SAVE_MS worth of learning.
+static void saveTravelModel(uint32_t now)
+{
+    if (!travelModelPending || now - lastTravelModelSave < TRAVEL_MODEL_SAVE_MS)
+        return;
+    const TravelModelParams &params = travelModel.getParams();
+    TravelModelStats stats = travelModel.getStats();
+    prefs.begin("ZBCover");
+    prefs.putBytes("travelModel", &params, sizeof(params));
+    prefs.putBytes("travelStats", &stats, sizeof(stats));
+    prefs.end();
+    travelModelPending = false;
+    lastTravelModelSave = now;
+}
+
+void vTravelModelTask(TimerHandle_t)
+{
+    if (stepperMotor == nullptr)
+        return;
+    if (!travelModel.isTripActive())
+    {
+        saveTravelModel(millis());
+        return;
+    }
+
+    uint32_t now = millis();
+    int32_t position = stepperMotor->getCurrentPosition();
+    bool running = stepperMotor->isRunning();
+    if (travelModel.sample(now, position, running))
+    {
+        const TravelErrorStats &stats = travelModel.getErrorStats(travelModel.getTripDirection());
+        Serial.printf("Arrived, mean travel time error: %.0f ms over %lu trips\n", stats.meanAbsErrorMs,
+                      static_cast<unsigned long>(stats.trips));
+        travelModelPending = true;
+        saveTravelModel(now);
+        publishEta(0);
+        return;
+    }
+
+    if (!running)
+    {
+        if (travelModel.overdueMs(now) > TRAVEL_TRIP_TIMEOUT_MS)
+            cancelTravel();
+        return;
+    }
+
+    // The controller extrapolates from the published ETA, so only correct it when it is noticeably off
+    // Drift in ms at the commanded speed, compared without dividing: |steps| / speed > limit
+    int32_t expected = travelModel.predictedPosition(now);
+    uint64_t driftStepMs = static_cast<uint64_t>(abs(position - expected)) * 1000;
+    if (driftStepMs > static_cast<uint64_t>(TRAVEL_ETA_REPUBLISH_MS) * stepperMotor->getSpeed())
+    {
+        travelModel.replan(now, position);
+        publishEta(travelModel.remainingMs(now));
+    }
 }
 
 void waitForMotorToStop()
@@ -68,11 +280,18 @@ void waitForMotorToStop()
 void homingRoutine()
 {
     Serial.println("Homing routine started.");
+    cancelTravel();
     if (stepperMotor != nullptr)
     {
-        stepperMotor->moveTo(stepperMotor->getCurrentPosition() + STEPS_PER_CM * -100);
+        // Far enough to reach the end stop from anywhere within the profile's travel
+        stepperMotor->moveTo(stepperMotor->getCurrentPosition() - ActiveHardware::MAX_POSITION);
         waitForMotorToStop();
         Serial.println("position after homing: " + String(stepperMotor->getCurrentPosition()));
+        if (flag_homingAborted)
+        {
+            Serial.println("Homing routine aborted.");
+            return; // Stopped by the user, not by the end stop: keep the old position
+        }
 
         stepperMotor->moveTo(stepperMotor->getCurrentPosition() + STEPS_PER_CM * 2); // Move back a few cm
         waitForMotorToStop();
@@ -119,25 +338,55 @@ void openCover()
             }
         }
         updatePosition(stepperMotor->getCurrentPosition());
-        vTaskDelete(NULL);
+        endMoveTask();
     };
-    xTaskCreate(openCoverTask, "OpenCoverTask", 2048, nullptr, 1, nullptr);
+    beginTravel(TOP_LIMIT * STEPS_PER_CM + liftBackOff);
+    startMoveTask(openCoverTask, "OpenCoverTask");
 }
 
 void closeCover()
 {
     if (&stepperMotor != nullptr)
+    {
+        beginTravel(BOTTOM_LIMIT * STEPS_PER_CM);
         stepperMotor->moveTo(BOTTOM_LIMIT * STEPS_PER_CM);
+    }
 }
 
 static uint8_t stopCounter = 0;
 static uint32_t lastStopTime = 0;
-static bool flag_homing = false;
+
+void startHoming()
+{
+    if (flag_homing)
+        return;
+
+    TaskFunction_t homingTask = [](void *)
+    {
+        homingRoutine();
+        flag_homing = false;
+        stopCounter = 0;
+        endMoveTask();
+    };
+    // Set before the task runs, so a stop right after the command already aborts it
+    flag_homing = true;
+    flag_homingAborted = false;
+    if (!startMoveTask(homingTask, "HomingTask"))
+        flag_homing = false;
+}
+
+bool isCoverMoving()
+{
+    return (stepperMotor != nullptr && stepperMotor->isRunning()) || activeMoveTasks > 0;
+}
 
 void stopCover()
 {
+    cancelTravel();
+
     if (flag_homing)
     {
+        flag_homingAborted = true;
         stepperMotor->forceStop();
         return;
     }
@@ -147,28 +396,31 @@ void stopCover()
         // If we are moving up, we release the tension by moving back down a bit
         if (stepperMotor->getTargetPosition() < stepperMotor->getCurrentPosition())
         {
-            stepperMotor->moveTo(stepperMotor->getCurrentPosition() + liftBackOff);
-            waitForMotorToStop();
+            coverTarget = stepperMotor->getCurrentPosition() + liftBackOff;
+            stepperMotor->moveTo(coverTarget);
+
+            // Wait for the back-off in a task, so the caller (Zigbee or loop()) is not blocked
+            TaskFunction_t stopBackOffTask = [](void *)
+            {
+                waitForMotorToStop();
+                updatePosition(stepperMotor->getCurrentPosition());
+                endMoveTask();
+            };
+            startMoveTask(stopBackOffTask, "StopBackOffTask");
+        }
+        else
+        {
+            stepperMotor->stop();
+            coverTarget = stepperMotor->getCurrentPosition();
+            updatePosition(stepperMotor->getCurrentPosition());
         }
-        stepperMotor->stop();
-        updatePosition(stepperMotor->getCurrentPosition());
     }
 
     // If stop is called three times in quick succession, we start homing procedure
     if (millis() - lastStopTime < 500)
     {
         if (++stopCounter >= 2)
-        {
-            TaskFunction_t homingTask = [](void *)
-            {
-                flag_homing = true;
-                homingRoutine();
-                flag_homing = false;
-                stopCounter = 0;
-                vTaskDelete(NULL);
-            };
-            xTaskCreate(homingTask, "HomingTask", 2048, nullptr, 1, nullptr);
-        }
+            startHoming();
     }
     else
     {
@@ -179,13 +431,15 @@ void stopCover()
 
 void goToLiftPercentage(uint8_t liftPercentage)
 {
-    float newLift = (TOP_LIMIT * 1.0 + (liftPercentage * 1.0 * (BOTTOM_LIMIT - TOP_LIMIT) / 100.0));
-    int32_t newPosition = static_cast<int32_t>(newLift * STEPS_PER_CM);
-    Serial.printf("New requested lift from Zigbee: %.2f cm / %d (%d \%)\n", newLift, newPosition, liftPercentage);
+    int64_t span = (static_cast<int64_t>(BOTTOM_LIMIT) - TOP_LIMIT) * STEPS_PER_CM;
+    int32_t newPosition = static_cast<int32_t>(static_cast<int64_t>(TOP_LIMIT) * STEPS_PER_CM + liftPercentage * span / 100);
+    Serial.printf("New requested lift from Zigbee: %d cm / %d (%d %%)\n", newPosition / static_cast<int32_t>(STEPS_PER_CM), newPosition,
+                  liftPercentage);
 
     if (&stepperMotor == nullptr)
         return;
 
+    beginTravel(newPosition);
     if (newPosition < stepperMotor->getCurrentPosition())
     {
         stepperMotor->moveTo(newPosition - liftBackOff); // Move to the target minus the lift back off
@@ -207,9 +461,9 @@ void goToLiftPercentage(uint8_t liftPercentage)
                     }
                 }
             }
-            vTaskDelete(NULL);
+            endMoveTask();
         };
-        xTaskCreate(backOffTask, "backOffTask", 2048, nullptr, 1, nullptr);
+        startMoveTask(backOffTask, "backOffTask");
     }
     else
     {
@@ -229,6 +483,7 @@ void onBottomLimitChange(float analog)
     if (flag_init && stepperMotor != nullptr)
     {
         Serial.printf("Moving to bottom lift: %d cm\n", BOTTOM_LIMIT);
+        beginTravel(BOTTOM_LIMIT * STEPS_PER_CM);
         stepperMotor->moveTo(BOTTOM_LIMIT * STEPS_PER_CM);
     }
 }
@@ -244,6 +499,7 @@ void onTopLimitChange(float analog)
     if (flag_init && stepperMotor != nullptr)
     {
         Serial.printf("Moving to top lift: %d cm\n", TOP_LIMIT);
+        beginTravel(TOP_LIMIT * STEPS_PER_CM);
         stepperMotor->moveTo(TOP_LIMIT * STEPS_PER_CM);
     }
 }
@@ -257,7 +513,7 @@ void onSpeedChange(float analog)
 
     if (flag_init && stepperMotor != nullptr)
     {
-        stepperMotor->setSpeed(analog, 8);
+        stepperMotor->setSpeed(static_cast<uint32_t>(analog));
     }
 }
 
@@ -272,6 +528,89 @@ void onAnalogStallSensitivityChange(float analog)
         stepperMotor->setSGTHRS(static_cast<uint8_t>(analog));
 }
 
+void setCoverSpeed(float speed)
+{
+    onSpeedChange(speed);
+    zbPublisher.set(ZB_ATTR_SPEED, lroundf(speed));
+}
+
+void setCoverStallSensitivity(uint8_t sgthrs)
+{
+    onAnalogStallSensitivityChange(sgthrs);
+    zbPublisher.set(ZB_ATTR_STALL_SENSITIVITY, sgthrs);
+}
+
+void setCoverTopLimit(uint16_t topLimit)
+{
+    onTopLimitChange(topLimit);
+    zbPublisher.set(ZB_ATTR_TOP_LIMIT, topLimit);
+}
+
+void setCoverBottomLimit(uint16_t bottomLimit)
+{
+    onBottomLimitChange(bottomLimit);
+    zbPublisher.set(ZB_ATTR_BOTTOM_LIMIT, bottomLimit);
+}
+
+// Attribute writes from the coordinator: it already has the value it wrote, so it is not reported
+// back, but a later local change back to the old value still is.
+static void onZigbeeSpeedChange(float analog)
+{
+    onSpeedChange(analog);
+    zbPublisher.assumePublished(ZB_ATTR_SPEED, lroundf(analog));
+}
+
+static void onZigbeeStallSensitivityChange(float analog)
+{
+    onAnalogStallSensitivityChange(analog);
+    zbPublisher.assumePublished(ZB_ATTR_STALL_SENSITIVITY, lroundf(analog));
+}
+
+static void onZigbeeTopLimitChange(float analog)
+{
+    onTopLimitChange(analog);
+    zbPublisher.assumePublished(ZB_ATTR_TOP_LIMIT, lroundf(analog));
+}
+
+static void onZigbeeBottomLimitChange(float analog)
+{
+    onBottomLimitChange(analog);
+    zbPublisher.assumePublished(ZB_ATTR_BOTTOM_LIMIT, lroundf(analog));
+}
+
+CoverState getCoverState()
+{
+    CoverState state = {};
+    state.topLimit = TOP_LIMIT;
+    state.bottomLimit = BOTTOM_LIMIT;
+    if (stepperMotor != nullptr)
+    {
+        state.position = stepperMotor->getCurrentPosition();
+        state.targetPosition = coverTarget;
+        state.running = isCoverMoving();
+        state.liftPercentage = liftPercentageAt(state.position);
+        state.speed = stepperMotor->getSpeed();
+        state.stallSensitivity = stepperMotor->getSGTHRS();
+    }
+    state.etaMs = travelModel.remainingMs(millis());
+    return state;
+}
+
+const TravelModel &getTravelModel()
+{
+    return travelModel;
+}
+
+bool hasPendingTravelModelSave()
+{
+    return travelModelPending;
+}
+
+bool hasPendingZigbeeReports()
+{
+    return zbPublisher.hasPending();
+}
+
 void createAndSetupZigbeeEndpoints()
 {
     zbCovering = new ZigbeeWindowCovering(10);
@@ -294,7 +633,7 @@ void createAndSetupZigbeeEndpoints()
     zbAnalogStallSensitivity->setAnalogOutputDescription("Stall sensitivity");
     zbAnalogStallSensitivity->setAnalogOutputResolution(1.0f);
     zbAnalogStallSensitivity->setAnalogOutputMinMax(0.0f, 144.0f); // Set min and max values for stall sensitivity
-    zbAnalogStallSensitivity->onAnalogOutputChange(onAnalogStallSensitivityChange);
+    zbAnalogStallSensitivity->onAnalogOutputChange(onZigbeeStallSensitivityChange);
 
     zbAnalogBottomLimit = new ZigbeeAnalog(13);
     zbAnalogBottomLimit->setManufacturerAndModel("sando@home", "WindowCoveringV3");
@@ -302,8 +641,8 @@ void createAndSetupZigbeeEndpoints()
     zbAnalogBottomLimit->setAnalogOutputApplication(ESP_ZB_ZCL_AO_APP_TYPE_COUNT_UNITLESS);
     zbAnalogBottomLimit->setAnalogOutputDescription("Max lift height in cm");
     zbAnalogBottomLimit->setAnalogOutputResolution(1.0f);
-    zbAnalogBottomLimit->setAnalogOutputMinMax(0.0f, 400.0f); // Set min and max values for lift height
-    zbAnalogBottomLimit->onAnalogOutputChange(onBottomLimitChange);
+    zbAnalogBottomLimit->setAnalogOutputMinMax(0.0f, ActiveHardware::MAX_LIMIT_CM); // Set min and max values for lift height
+    zbAnalogBottomLimit->onAnalogOutputChange(onZigbeeBottomLimitChange);
 
     zbAnalogTopLimit = new ZigbeeAnalog(14);
     zbAnalogTopLimit->setManufacturerAndModel("sando@home", "WindowCoveringV3");
@@ -311,8 +650,8 @@ void createAndSetupZigbeeEndpoints()
     zbAnalogTopLimit->setAnalogOutputApplication(ESP_ZB_ZCL_AO_APP_TYPE_COUNT_UNITLESS);
     zbAnalogTopLimit->setAnalogOutputDescription("Max lift height in cm");
     zbAnalogTopLimit->setAnalogOutputResolution(1.0f);
-    zbAnalogTopLimit->setAnalogOutputMinMax(0.0f, 400.0f); // Set min and max values for lift height
-    zbAnalogTopLimit->onAnalogOutputChange(onTopLimitChange);
+    zbAnalogTopLimit->setAnalogOutputMinMax(0.0f, ActiveHardware::MAX_LIMIT_CM); // Set min and max values for lift height
+    zbAnalogTopLimit->onAnalogOutputChange(onZigbeeTopLimitChange);
 
     zbAnalogSpeed = new ZigbeeAnalog(15);
     zbAnalogSpeed->setManufacturerAndModel("sando@home", "WindowCoveringV3");
@@ -320,14 +659,29 @@ void createAndSetupZigbeeEndpoints()
     zbAnalogSpeed->setAnalogOutputApplication(ESP_ZB_ZCL_AO_APP_TYPE_COUNT_UNITLESS);
     zbAnalogSpeed->setAnalogOutputDescription("Stepper speed");
     zbAnalogSpeed->setAnalogOutputResolution(1.0f);
-    zbAnalogSpeed->setAnalogOutputMinMax(0.0f, 15000.0f); // Set min and max values for speed
-    zbAnalogSpeed->onAnalogOutputChange(onSpeedChange);
+    zbAnalogSpeed->setAnalogOutputMinMax(0.0f, ActiveHardware::MAX_SPEED); // Set min and max values for speed
+    zbAnalogSpeed->onAnalogOutputChange(onZigbeeSpeedChange);
+
+    zbAnalogEta = new ZigbeeAnalog(16);
+    zbAnalogEta->setManufacturerAndModel("sando@home", "WindowCoveringV3");
+    zbAnalogEta->addAnalogInput();
+    zbAnalogEta->setAnalogInputDescription("Seconds until target reached");
+    zbAnalogEta->setAnalogInputResolution(0.1f);
+    zbAnalogEta->setAnalogInputMinMax(0.0f, 600.0f);
 
     Zigbee.addEndpoint(zbCovering);
     Zigbee.addEndpoint(zbAnalogStallSensitivity);
     Zigbee.addEndpoint(zbAnalogBottomLimit);
     Zigbee.addEndpoint(zbAnalogTopLimit);
     Zigbee.addEndpoint(zbAnalogSpeed);
+    Zigbee.addEndpoint(zbAnalogEta);
+
+    zbPublisher.attach(ZB_ATTR_LIFT_PERCENTAGE, nullptr, reportLiftPercentage, 1, ZIGBEE_LIFT_MIN_INTERVAL_MS, false);
+    zbPublisher.attach(ZB_ATTR_STALL_SENSITIVITY, applyStallSensitivity, reportStallSensitivity, 1, ZIGBEE_CONFIG_MIN_INTERVAL_MS, true);
+    zbPublisher.attach(ZB_ATTR_BOTTOM_LIMIT, applyBottomLimit, reportBottomLimit, 1, ZIGBEE_CONFIG_MIN_INTERVAL_MS, true);
+    zbPublisher.attach(ZB_ATTR_TOP_LIMIT, applyTopLimit, reportTopLimit, 1, ZIGBEE_CONFIG_MIN_INTERVAL_MS, true);
+    zbPublisher.attach(ZB_ATTR_SPEED, applySpeed, reportSpeed, 1, ZIGBEE_CONFIG_MIN_INTERVAL_MS, true);
+    zbPublisher.attach(ZB_ATTR_ETA, nullptr, reportEta, 100, ZIGBEE_ETA_MIN_INTERVAL_MS, false); // ms, reported in 0.1 s
 }
 
 void readAndUpdateZigbeeCoverState(StepperUart &motor)
@@ -338,6 +692,15 @@ void readAndUpdateZigbeeCoverState(StepperUart &motor)
     BOTTOM_LIMIT = prefs.getUInt("bottomLimit", 100); // Default to 100cm if not set
     TOP_LIMIT = prefs.getUInt("topLimit", 10);        // Default to 10cm if not set
     float speed = prefs.getFloat("speed", 7500.0f);   // Default to 7500 steps/s if not set
+    TravelModelParams travelParams;
+    bool travelLearned = prefs.getBytes("travelModel", &travelParams, sizeof(travelParams)) == sizeof(travelParams) &&
+                         travelModel.setParams(travelParams);
+    TravelModelStats travelStats;
+    bool statsKnown = prefs.getBytes("travelStats", &travelStats, sizeof(travelStats)) == sizeof(travelStats) &&
+                      travelModel.setStats(travelStats);
+    ZigbeePublishedSnapshot published;
+    bool publishedKnown = prefs.getBytes("zbPublished", &published, sizeof(published)) == sizeof(published) &&
+                          zbPublisher.restore(published);
     prefs.end();
 
     Serial.printf("Read and applied configs from prefs:\n");
@@ -346,8 +709,11 @@ void readAndUpdateZigbeeCoverState(StepperUart &motor)
     Serial.printf("bottom limit: %d cm\n", BOTTOM_LIMIT);
     Serial.printf("top limit: %d cm\n", TOP_LIMIT);
     Serial.printf("speed: %.0f\n", speed);
+    Serial.printf("travel model: %s\n", travelLearned ? "learned" : "default");
+    Serial.printf("travel stats: %s\n", statsKnown ? "restored" : "empty");
+    Serial.printf("zigbee state: %s\n", publishedKnown ? "restored" : "unknown");
 
-    uint8_t savedLiftPercentage = (savedPosition / STEPS_PER_CM - TOP_LIMIT) * 100 / (BOTTOM_LIMIT - TOP_LIMIT);
+    uint8_t savedLiftPercentage = liftPercentageClamped(savedPosition);
     Serial.printf("Calculated lift percentage: %d\n", savedLiftPercentage);
     Serial.printf("Calculated lift in cm: %d\n", savedPosition / STEPS_PER_CM);
 
@@ -355,29 +721,40 @@ void readAndUpdateZigbeeCoverState(StepperUart &motor)
     if (stepperMotor != nullptr)
     {
         stepperMotor->setCurrentPosition(savedPosition);
+        coverTarget = savedPosition;
         stepperMotor->setSGTHRS(SGTHRS);
-        stepperMotor->setSpeed(speed, 8);
-    }
-    if (Zigbee.started() && zbCovering != nullptr)
-    {
-        zbCovering->setLiftPercentage(savedLiftPercentage);
-    }
-    if (Zigbee.started() && zbAnalogStallSensitivity != nullptr)
-    {
-        zbAnalogStallSensitivity->setAnalogOutput(static_cast<float>(SGTHRS));
-    }
-    if (Zigbee.started() && zbAnalogBottomLimit != nullptr)
-    {
-        zbAnalogBottomLimit->setAnalogOutput(static_cast<float>(BOTTOM_LIMIT));
-    }
-    if (Zigbee.started() && zbAnalogTopLimit != nullptr)
-    {
-        zbAnalogTopLimit->setAnalogOutput(static_cast<float>(TOP_LIMIT));
-    }
-    if (Zigbee.started() && zbAnalogSpeed != nullptr)
-    {
-        zbAnalogSpeed->setAnalogOutput(speed);
+        stepperMotor->setSpeed(static_cast<uint32_t>(speed));
     }
 
+    // Queue the boot state and send it together after a random delay, so blinds powered on at the
+    // same time don't flood the mesh. Values the coordinator already has are set locally but not
+    // reported, and the ETA of a move cut short by a power loss has already counted down to 0 on
+    // the controller.
+    zbPublisher.assumePublished(ZB_ATTR_ETA, 0);
+    zbPublisher.set(ZB_ATTR_LIFT_PERCENTAGE, savedLiftPercentage);
+    zbPublisher.set(ZB_ATTR_STALL_SENSITIVITY, SGTHRS);
+    zbPublisher.set(ZB_ATTR_BOTTOM_LIMIT, BOTTOM_LIMIT);
+    zbPublisher.set(ZB_ATTR_TOP_LIMIT, TOP_LIMIT);
+    zbPublisher.set(ZB_ATTR_SPEED, lroundf(speed));
+    zbPublisher.holdUntil(millis() + random(ZIGBEE_BOOT_JITTER_MS));
+
+    TimerHandle_t publishTimer = xTimerCreate(
+        "ZigbeePublishTask",                       // Timer name
+        pdMS_TO_TICKS(ZIGBEE_PUBLISH_INTERVAL_MS), // Timer interval
+        pdTRUE,                                    // Auto-reload
+        nullptr,                                   // No timer ID needed
+        vZigbeePublishTask                         // Callback function
+    );
+    xTimerStart(publishTimer, 0);
+
+    TimerHandle_t travelTimer = xTimerCreate(
+        "TravelTask",                             // Timer name
+        pdMS_TO_TICKS(TRAVEL_SAMPLE_INTERVAL_MS), // Timer interval
+        pdTRUE,                                   // Auto-reload
+        nullptr,                                  // No timer ID needed
+        vTravelModelTask                          // Callback function
+    );
+    xTimerStart(travelTimer, 0);
+
     flag_init = true;
 }
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "ZigbeePublisher.h"
+
+ZigbeePublisher::ZigbeePublisher()
+    : holdUntilMs(0), framesSent(0), snapshotChanged(false), lock(portMUX_INITIALIZER_UNLOCKED)
+{
+    for (int i = 0; i < ZB_ATTR_COUNT; i++)
+        slots[i] = Slot{nullptr, nullptr, 1, 0, false, false, false, false, false, 0, 0, 0, 0};
+}
+
+void ZigbeePublisher::attach(ZigbeeAttribute attribute, ApplyFunction apply, ReportFunction report, int32_t resolution, uint32_t minIntervalMs, bool persistent)
+{
+    Slot &slot = slots[attribute];
+    slot.apply = apply;
+    slot.report = report;
+    slot.resolution = resolution > 0 ? resolution : 1;
+    slot.minIntervalMs = minIntervalMs;
+    slot.persistent = persistent;
+}
+
+// Rounds to the nearest multiple of `resolution`, halves away from zero
+static int32_t roundTo(int32_t value, int32_t resolution)
+{
+    return value >= 0 ? (value + resolution / 2) / resolution : -((resolution / 2 - value) / resolution);
+}
+
+bool ZigbeePublisher::sameValue(const Slot &slot, int32_t a, int32_t b) const
+{
+    return roundTo(a, slot.resolution) == roundTo(b, slot.resolution);
+}
+
+void ZigbeePublisher::set(ZigbeeAttribute attribute, int32_t value, bool immediate)
+{
+    Slot &slot = slots[attribute];
+    portENTER_CRITICAL(&lock);
+    slot.revision++;
+    slot.pending = value;
+    slot.applyPending = slot.apply != nullptr;
+    // Back to what the coordinator already has, nothing to report
+    slot.dirty = !(slot.published && sameValue(slot, value, slot.lastPublished));
+    slot.immediate = immediate;
+    portEXIT_CRITICAL(&lock);
+}
+
+void ZigbeePublisher::assumePublished(ZigbeeAttribute attribute, int32_t value)
+{
+    Slot &slot = slots[attribute];
+    portENTER_CRITICAL(&lock);
+    if (slot.persistent && !(slot.published && sameValue(slot, slot.lastPublished, value)))
+        snapshotChanged = true;
+    slot.revision++;
+    slot.pending = value;
+    slot.applyPending = false; // The coordinator wrote the local attribute itself
+    slot.dirty = false;
+    slot.published = true;
+    slot.lastPublished = value;
+    portEXIT_CRITICAL(&lock);
+}
+
+void ZigbeePublisher::holdUntil(uint32_t nowMs)
+{
+    portENTER_CRITICAL(&lock);
+    holdUntilMs = nowMs;
+    portEXIT_CRITICAL(&lock);
+}
+
+// The lock is never held across apply() or report(): both wait for the Zigbee stack, whose task
+// calls back into set() and assumePublished(). The revision tells whether the slot changed meanwhile.
+bool ZigbeePublisher::flush(uint32_t nowMs)
+{
+    // Local attributes go nowhere, so they are set even while reports are held back
+    for (int i = 0; i < ZB_ATTR_COUNT; i++)
+    {
+        Slot &slot = slots[i];
+        portENTER_CRITICAL(&lock);
+        bool due = slot.applyPending;
+        int32_t value = slot.pending;
+        uint32_t revision = slot.revision;
+        portEXIT_CRITICAL(&lock);
+        if (!due || !slot.apply(value))
+            continue; // Retry on the next flush
+
+        portENTER_CRITICAL(&lock);
+        slot.applyPending = slot.revision != revision; // A newer value may have been overwritten
+        portEXIT_CRITICAL(&lock);
+    }
+
+    portENTER_CRITICAL(&lock);
+    bool held = static_cast<int32_t>(nowMs - holdUntilMs) < 0;
+    bool persistentChanged = !held && snapshotChanged;
+    if (!held)
+        snapshotChanged = false;
+    portEXIT_CRITICAL(&lock);
+    if (held)
+        return false;
+
+    int frames = 0;
+    for (int i = 0; i < ZB_ATTR_COUNT && frames < ZIGBEE_MAX_FRAMES_PER_FLUSH; i++)
+    {
+        Slot &slot = slots[i];
+        portENTER_CRITICAL(&lock);
+        bool due = slot.dirty && slot.report != nullptr &&
+                   (!slot.published || slot.immediate || nowMs - slot.lastPublishMs >= slot.minIntervalMs);
+        int32_t value = slot.pending;
+        uint32_t revision = slot.revision;
+        portEXIT_CRITICAL(&lock);
+        if (!due || !slot.report(value))
+            continue; // Retry on the next flush
+
+        portENTER_CRITICAL(&lock);
+        slot.published = true;
+        slot.lastPublished = value;
+        slot.lastPublishMs = nowMs;
+        if (slot.revision == revision)
+            slot.dirty = false;
+        else // Updated while the report was on its way, send the newer value too
+            slot.dirty = !sameValue(slot, slot.pending, value);
+        slot.immediate = slot.immediate && slot.dirty;
+        framesSent++;
+        portEXIT_CRITICAL(&lock);
+        frames++;
+        persistentChanged = persistentChanged || slot.persistent;
+    }
+    return persistentChanged;
+}
+
+bool ZigbeePublisher::hasPending() const
+{
+    bool pending = false;
+    portENTER_CRITICAL(&lock);
+    for (int i = 0; i < ZB_ATTR_COUNT; i++)
+        pending = pending || slots[i].dirty || slots[i].applyPending;
+    portEXIT_CRITICAL(&lock);
+    return pending;
+}
+
+ZigbeePublishedSnapshot ZigbeePublisher::snapshot() const
+{
+    ZigbeePublishedSnapshot snapshot = {};
+    snapshot.version = ZIGBEE_PUBLISHED_VERSION;
+    portENTER_CRITICAL(&lock);
+    for (int i = 0; i < ZB_ATTR_COUNT; i++)
+    {
+        if (slots[i].persistent && slots[i].published)
+        {
+            snapshot.validMask |= 1 << i;
+            snapshot.values[i] = slots[i].lastPublished;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+    return snapshot;
+}
+
+bool ZigbeePublisher::restore(const ZigbeePublishedSnapshot &snapshot)
+{
+    if (snapshot.version != ZIGBEE_PUBLISHED_VERSION)
+        return false;
+    for (int i = 0; i < ZB_ATTR_COUNT; i++)
+    {
+        if (slots[i].persistent && (snapshot.validMask & (1 << i)))
+            assumePublished(static_cast<ZigbeeAttribute>(i), snapshot.values[i]);
+    }
+    portENTER_CRITICAL(&lock);
+    snapshotChanged = false; // Restored from the saved snapshot, nothing new to save
+    portEXIT_CRITICAL(&lock);
+    return true;
+}
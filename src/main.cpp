@@ -6,15 +6,14 @@
 #include "ZigbeeCore.h"
 #include "StepperUart.h"
 #include "ZigbeeCoveringHelper.h"
+#include "SerialCommand.h"
+#include "HardwareProfile.h"
 
 #define ZIGBEE_COVERING_ENDPOINT 10
-#define BUTTON_PIN 9 // ESP32-C6/H2 Boot button
+#define BUTTON_PIN ActiveHardware::BUTTON_PIN // ESP32-C6/H2 Boot button
 
-#define MOTOR_DIR_PIN 18
-#define MOTOR_STEP_PIN 20
-#define MOTOR_ENABLE_PIN 23
-
-StepperUart stepperMotor(MOTOR_DIR_PIN, MOTOR_STEP_PIN, MOTOR_ENABLE_PIN);
+StepperUart stepperMotor; // Pins come from the hardware profile
+SerialCommand serialCommand(Serial, stepperMotor);
 
 void blink(uint8_t count)
 {
@@ -35,8 +34,8 @@ void setup()
   pinMode(LED_BUILTIN, OUTPUT);      // Init LED pin
   digitalWrite(LED_BUILTIN, LOW);    // Turn on LED
 
-  pinMode(MOTOR_ENABLE_PIN, OUTPUT);
-  digitalWrite(MOTOR_ENABLE_PIN, HIGH); // Disable motor during setup
+  pinMode(ActiveHardware::ENABLE_PIN, OUTPUT);
+  digitalWrite(ActiveHardware::ENABLE_PIN, HIGH); // Disable motor during setup
 
   // Wait a while for serial monitor to connect
   delay(2000);
@@ -102,69 +101,7 @@ void loop()
     buttonPressTime = 0;
   }
 
-  switch (Serial.read())
-  {
-  case 'o':
-    openCover();
-    break;
-  case 'c':
-    closeCover();
-    break;
-  case 's':
-    stopCover();
-    break;
-  case 'h':
-    homingRoutine();
-    break;
-  case '1':
-    stepperMotor.setSpeed(1000, 8);
-    blink(1);
-    break;
-  case '2':
-    stepperMotor.setSpeed(2400, 8);
-    blink(2);
-    break;
-  case '3':
-    stepperMotor.setSpeed(5000, 8);
-    blink(3);
-    break;
-  case '4':
-    stepperMotor.setSpeed(7500, 8);
-    blink(3);
-    break;
-  case '5':
-    stepperMotor.setSpeed(10000, 8);
-    blink(3);
-    break;
-
-  case '+':
-    {
-      uint8_t currentSGTHRS = stepperMotor.getSGTHRS();
-      if (currentSGTHRS < 144)
-      {
-        stepperMotor.setSGTHRS(currentSGTHRS + 10);
-        Serial.printf("Increased SGTHRS to: %d\n", currentSGTHRS + 10);
-      }
-      else
-      {
-        Serial.println("SGTHRS is already at maximum (144).");
-      }
-    }
-    break;
-  
-  case '-':
-    {
-      uint8_t currentSGTHRS = stepperMotor.getSGTHRS();
-      if (currentSGTHRS > 0)
-      {
-        stepperMotor.setSGTHRS(currentSGTHRS - 10);
-        Serial.printf("Decreased SGTHRS to: %d\n", currentSGTHRS - 10);
-      }
-      else
-      {
-        Serial.println("SGTHRS is already at minimum (0).");
-      }
-    }
-  }
-  vTaskDelay(portTICK_PERIOD_MS * 50); // Yield to other tasks
+  serialCommand.poll();
+
+  vTaskDelay(portTICK_PERIOD_MS * 5); // Yield to other tasks
 }
@@ -0,0 +1,77 @@
+#pragma once
+
+// Host stand-in for the Arduino-ESP32 core, just enough to build the firmware sources against the
+// simulated hardware in test/sim.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "sim/SimKernel.h"
+#include "HardwareSerial.h"
+
+typedef bool boolean;
+
+#define PI 3.1415926535897932384626433832795
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define LED_BUILTIN 15
+
+class String : public std::string
+{
+public:
+    String(const char *text = "") : std::string(text) {}
+    String(const std::string &text) : std::string(text) {}
+    String(int value) : std::string(std::to_string(value)) {}
+    String(long value) : std::string(std::to_string(value)) {}
+    String(unsigned int value) : std::string(std::to_string(value)) {}
+    String(unsigned long value) : std::string(std::to_string(value)) {}
+};
+
+inline HardwareSerial Serial(0);
+
+class EspClass
+{
+public:
+    uint32_t getHeapSize() { return 320 * 1024; }
+    uint32_t getFreeHeap() { return getHeapSize() - static_cast<uint32_t>(sim::Kernel::instance().heapBytes); }
+    uint32_t getMinFreeHeap() { return getHeapSize() - static_cast<uint32_t>(sim::Kernel::instance().peakHeapBytes); }
+};
+
+inline EspClass ESP;
+
+inline unsigned long millis()
+{
+    return static_cast<unsigned long>(sim::Kernel::instance().now());
+}
+
+inline void delay(uint32_t ms)
+{
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+// Seeded from the boot time, so each simulated power-on draws a different sequence but a run is
+// reproducible.
+inline long random(long howsmall, long howbig)
+{
+    static std::minstd_rand rng(static_cast<uint32_t>(sim::Kernel::instance().now()) + 1);
+    if (howsmall >= howbig)
+        return howsmall;
+    return howsmall + static_cast<long>(rng() % static_cast<unsigned long>(howbig - howsmall));
+}
+
+inline long random(long howbig)
+{
+    return random(0, howbig);
+}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return HIGH; }
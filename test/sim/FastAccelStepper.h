@@ -0,0 +1,151 @@
+#pragma once
+
+// Host stand-in for FastAccelStepper: a trapezoidal ramp generator advanced one millisecond at a
+// time by the simulation kernel. Each generated step moves the simulated blind unless it is pushing
+// against the top end stop, in which case the step is lost and the driver reports a stall.
+
+#include <cmath>
+#include <cstdint>
+
+#include "sim/SimWorld.h"
+
+class FastAccelStepper;
+
+namespace sim
+{
+    inline FastAccelStepper *&activeStepper()
+    {
+        static FastAccelStepper *stepper = nullptr;
+        return stepper;
+    }
+}
+
+class FastAccelStepper
+{
+public:
+    void setDirectionPin(uint8_t pin, bool dirHighCountsUp = true, uint16_t dirChangeDelayUs = 0)
+    {
+        (void)pin;
+        (void)dirHighCountsUp;
+        (void)dirChangeDelayUs;
+    }
+    void setEnablePin(uint8_t pin, bool lowActive = true)
+    {
+        (void)pin;
+        (void)lowActive;
+    }
+    void setAutoEnable(bool autoEnable) { (void)autoEnable; }
+    void setDelayToDisable(uint16_t delayMs) { (void)delayMs; }
+
+    int8_t setSpeedInHz(uint32_t hz)
+    {
+        maxHz = hz;
+        return 0;
+    }
+    int8_t setAcceleration(int32_t stepsPerSecond2)
+    {
+        acceleration = stepsPerSecond2;
+        return 0;
+    }
+
+    int8_t moveTo(int32_t position, bool blocking = false)
+    {
+        (void)blocking;
+        if (!running)
+            sim::world().blocked = false;
+        target = position;
+        running = running || target != current;
+        return 0;
+    }
+    void stopMove()
+    {
+        if (!running)
+            return;
+        int32_t stopDistance = static_cast<int32_t>(std::ceil(velocity * velocity / (2.0 * acceleration)));
+        target = velocity >= 0 ? current + stopDistance : current - stopDistance;
+    }
+    void forceStop()
+    {
+        velocity = 0;
+        fraction = 0;
+        target = current;
+        running = false;
+    }
+
+    int32_t getCurrentPosition() const { return current; }
+    void setCurrentPosition(int32_t position)
+    {
+        target += position - current;
+        current = position;
+    }
+    bool isRunning() const { return running; }
+
+    // Advances the ramp by one millisecond.
+    void simTick()
+    {
+        sim::World &w = sim::world();
+        w.blocked = false;
+        if (!running)
+            return;
+
+        const double dv = acceleration / 1000.0;
+        const int32_t remaining = target - current;
+        const int direction = remaining > 0 ? 1 : (remaining < 0 ? -1 : 0);
+        const double stopDistance = velocity * velocity / (2.0 * acceleration);
+
+        if (velocity != 0 && (velocity > 0 ? 1 : -1) != direction)
+            velocity = velocity > 0 ? std::fmax(0.0, velocity - dv) : std::fmin(0.0, velocity + dv);
+        else if (std::abs(remaining) <= stopDistance)
+            velocity = velocity > 0 ? std::fmax(dv, velocity - dv) : std::fmin(-dv, velocity + dv);
+        else if (direction != 0)
+            velocity = direction * std::fmin(static_cast<double>(maxHz), std::abs(velocity) + dv);
+
+        fraction += velocity / 1000.0;
+        while (fraction >= 1.0 || fraction <= -1.0)
+        {
+            int step = fraction > 0 ? 1 : -1;
+            if (current == target)
+                break;
+            fraction -= step;
+            current += step;
+            if (step < 0 && w.physicalSteps - 1 < w.hardStopSteps)
+                w.blocked = true; // step lost against the end stop
+            else
+                w.physicalSteps += step;
+        }
+
+        if (current == target && std::abs(velocity) <= dv)
+            forceStop();
+    }
+
+private:
+    int32_t current = 0;
+    int32_t target = 0;
+    uint32_t maxHz = 1000;
+    int32_t acceleration = 1000;
+    double velocity = 0;
+    double fraction = 0;
+    bool running = false;
+};
+
+class FastAccelStepperEngine
+{
+public:
+    void init() {}
+
+    FastAccelStepper *stepperConnectToPin(uint8_t stepPin)
+    {
+        (void)stepPin;
+        sim::activeStepper() = &stepper;
+        return &stepper;
+    }
+
+    ~FastAccelStepperEngine()
+    {
+        if (sim::activeStepper() == &stepper)
+            sim::activeStepper() = nullptr;
+    }
+
+private:
+    FastAccelStepper stepper;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+// Host stand-in for the ESP32 UART driver. Output is discarded unless sim::serialEcho is set; input
+// comes from whatever the harness queued with simInput().
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "Stream.h"
+
+namespace sim
+{
+    inline bool &serialEcho()
+    {
+        static bool echo = false;
+        return echo;
+    }
+}
+
+class HardwareSerial : public Stream
+{
+public:
+    explicit HardwareSerial(int uartNum) : uartNum(uartNum) {}
+
+    void begin(unsigned long baud) { (void)baud; }
+
+    int available() override { return static_cast<int>(input.size() - inputPos); }
+    int read() override { return inputPos < input.size() ? static_cast<uint8_t>(input[inputPos++]) : -1; }
+
+    size_t write(const uint8_t *data, size_t len) override
+    {
+        if (sim::serialEcho())
+            fwrite(data, 1, len, stdout);
+        return len;
+    }
+
+    void simInput(const std::string &data)
+    {
+        input.erase(0, inputPos);
+        inputPos = 0;
+        input += data;
+    }
+
+private:
+    int uartNum;
+    std::string input;
+    size_t inputPos = 0;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+// Host stand-in for the ESP32 Preferences (NVS) library, backed by the simulated flash in
+// sim::World so values survive simulated power cuts. Every put that changes a value counts as a
+// flash write.
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "sim/SimWorld.h"
+
+class Preferences
+{
+public:
+    bool begin(const char *name, bool readOnly = false)
+    {
+        (void)readOnly;
+        strncpy(ns, name, sizeof(ns) - 1);
+        ns[sizeof(ns) - 1] = '\0';
+        return true;
+    }
+    void end() {}
+
+    int32_t getInt(const char *key, int32_t defaultValue = 0) { return get<int32_t>(key, defaultValue); }
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0) { return get<uint32_t>(key, defaultValue); }
+    float getFloat(const char *key, float defaultValue = NAN) { return get<float>(key, defaultValue); }
+
+    size_t putInt(const char *key, int32_t value) { return put(key, &value, sizeof(value)); }
+    size_t putUInt(const char *key, uint32_t value) { return put(key, &value, sizeof(value)); }
+    size_t putFloat(const char *key, float value) { return put(key, &value, sizeof(value)); }
+
+    size_t getBytesLength(const char *key)
+    {
+        const sim::NvsEntry *entry = sim::nvsFind(ns, key, false);
+        return entry == nullptr ? 0 : entry->length;
+    }
+    size_t getBytes(const char *key, void *buffer, size_t maxLen)
+    {
+        const sim::NvsEntry *entry = sim::nvsFind(ns, key, false);
+        if (entry == nullptr || entry->length > maxLen)
+            return 0;
+        memcpy(buffer, entry->data, entry->length);
+        return entry->length;
+    }
+    size_t putBytes(const char *key, const void *value, size_t len) { return put(key, value, len); }
+
+private:
+    template <typename T>
+    T get(const char *key, T defaultValue)
+    {
+        const sim::NvsEntry *entry = sim::nvsFind(ns, key, false);
+        if (entry == nullptr || entry->length != sizeof(T))
+            return defaultValue;
+        T value;
+        memcpy(&value, entry->data, sizeof(T));
+        return value;
+    }
+
+    size_t put(const char *key, const void *value, size_t len)
+    {
+        if (len > sim::NVS_MAX_VALUE_BYTES)
+            return 0;
+        sim::World &w = sim::world();
+        ++w.nvsPuts;
+        sim::NvsEntry *entry = sim::nvsFind(ns, key, false);
+        if (entry != nullptr && entry->length == len && memcmp(entry->data, value, len) == 0)
+            return len; // NVS skips writes of an unchanged value
+        entry = sim::nvsFind(ns, key, true);
+        if (entry == nullptr)
+            return 0;
+        memcpy(entry->data, value, len);
+        entry->length = static_cast<uint16_t>(len);
+        ++w.nvsWrites;
+        return len;
+    }
+
+    char ns[16] = {};
+};
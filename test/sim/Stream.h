@@ -0,0 +1,40 @@
+#pragma once
+
+// Host stand-ins for the Arduino Print and Stream interfaces.
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+class Print
+{
+public:
+    virtual ~Print() = default;
+    virtual size_t write(const uint8_t *data, size_t len) = 0;
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        char buffer[512];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        if (len < 0)
+            return 0;
+        return write(reinterpret_cast<const uint8_t *>(buffer), std::min(static_cast<size_t>(len), sizeof(buffer) - 1));
+    }
+    size_t print(const char *text) { return write(reinterpret_cast<const uint8_t *>(text), strlen(text)); }
+    size_t print(const std::string &text) { return write(reinterpret_cast<const uint8_t *>(text.c_str()), text.size()); }
+    size_t println(const char *text = "") { return print(text) + print("\n"); }
+    size_t println(const std::string &text) { return print(text) + print("\n"); }
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+};
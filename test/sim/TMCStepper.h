@@ -0,0 +1,90 @@
+#pragma once
+
+// Host stand-in for the TMC2209 UART interface. Register state lives in this process (the driver
+// loses it on a power cut too). DIAG goes high while the rotor is blocked against the end stop and
+// StallGuard is enabled, or when a spurious stall has been injected. During an injected UART error
+// window reads return 0 and writes are lost, like CRC failures on the real bus.
+
+#include <cstdint>
+
+#include "HardwareSerial.h"
+#include "sim/SimKernel.h"
+#include "sim/SimWorld.h"
+
+namespace sim
+{
+    struct TmcRegisters
+    {
+        uint16_t microsteps = 256;
+        uint16_t rmsCurrent = 0;
+        uint32_t tcoolthrs = 0;
+        uint8_t sgthrs = 0;
+        bool spreadCycle = false;
+    };
+
+    inline TmcRegisters &tmcRegisters()
+    {
+        static TmcRegisters registers;
+        return registers;
+    }
+
+    inline bool uartError()
+    {
+        return Kernel::instance().now() < world().uartErrorUntil;
+    }
+}
+
+class TMC2209Stepper
+{
+public:
+    TMC2209Stepper(HardwareSerial *serial, float rSense, uint8_t address)
+    {
+        (void)serial;
+        (void)rSense;
+        (void)address;
+    }
+
+    void begin() {}
+
+    void rms_current(uint16_t mA) { write(regs().rmsCurrent, mA); }
+    void microsteps(uint16_t ms) { write(regs().microsteps, ms); }
+    uint16_t microsteps() { return read(regs().microsteps); }
+    void TCOOLTHRS(uint32_t value) { write(regs().tcoolthrs, value); }
+    uint32_t TCOOLTHRS() { return read(regs().tcoolthrs); }
+    void SGTHRS(uint8_t value) { write(regs().sgthrs, value); }
+    uint8_t SGTHRS() { return read(regs().sgthrs); }
+    void pwm_autoscale(bool) {}
+    void pwm_autograd(bool) {}
+    void en_spreadCycle(bool value) { write(regs().spreadCycle, value); }
+
+    bool diag()
+    {
+        if (sim::uartError())
+            return false;
+        sim::World &w = sim::world();
+        uint64_t now = sim::Kernel::instance().now();
+        if (w.spuriousDiagAt != 0 && now >= w.spuriousDiagAt)
+        {
+            w.spuriousDiagAt = 0;
+            return true;
+        }
+        return w.blocked && regs().sgthrs > 0;
+    }
+    uint16_t SG_RESULT() { return sim::uartError() ? 0 : (sim::world().blocked ? 0 : 300); }
+    uint32_t TSTEP() { return 0xFFFFF; }
+
+private:
+    static sim::TmcRegisters &regs() { return sim::tmcRegisters(); }
+
+    template <typename T, typename V>
+    static void write(T &reg, V value)
+    {
+        if (!sim::uartError())
+            reg = static_cast<T>(value);
+    }
+    template <typename T>
+    static T read(const T &reg)
+    {
+        return sim::uartError() ? T{} : reg;
+    }
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+// Host stand-in for the Arduino-ESP32 Zigbee core. Endpoints keep the callbacks the firmware
+// registers so the harness can drive them like a coordinator would, and every attribute report the
+// firmware pushes is counted as one frame on the mesh.
+
+#include <cstdint>
+#include <vector>
+
+#define ESP_ZB_ZCL_AO_APP_TYPE_COUNT_UNITLESS 0x000D0000
+
+namespace sim
+{
+    struct ZigbeeStats
+    {
+        uint64_t frames = 0;
+    };
+
+    inline ZigbeeStats &zigbeeStats()
+    {
+        static ZigbeeStats stats;
+        return stats;
+    }
+}
+
+class ZigbeeEP
+{
+public:
+    explicit ZigbeeEP(uint8_t endpoint) : endpoint(endpoint) {}
+    virtual ~ZigbeeEP() = default;
+
+    void setManufacturerAndModel(const char *manufacturer, const char *model)
+    {
+        (void)manufacturer;
+        (void)model;
+    }
+    uint8_t getEndpoint() const { return endpoint; }
+
+protected:
+    bool report()
+    {
+        ++sim::zigbeeStats().frames;
+        return true;
+    }
+
+private:
+    uint8_t endpoint;
+};
+
+class ZigbeeCore
+{
+public:
+    bool begin()
+    {
+        isStarted = true;
+        return true;
+    }
+    bool started() const { return isStarted; }
+    bool connected() const { return isStarted; }
+    bool addEndpoint(ZigbeeEP *ep)
+    {
+        endpoints.push_back(ep);
+        return true;
+    }
+
+    ZigbeeEP *simEndpoint(uint8_t id) const
+    {
+        for (ZigbeeEP *ep : endpoints)
+            if (ep->getEndpoint() == id)
+                return ep;
+        return nullptr;
+    }
+
+private:
+    bool isStarted = false;
+    std::vector<ZigbeeEP *> endpoints;
+};
+
+inline ZigbeeCore Zigbee;
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ZigbeeCore.h"
+
+class ZigbeeAnalog : public ZigbeeEP
+{
+public:
+    explicit ZigbeeAnalog(uint8_t endpoint) : ZigbeeEP(endpoint) {}
+
+    bool addAnalogOutput() { return true; }
+    bool setAnalogOutputApplication(uint32_t application)
+    {
+        (void)application;
+        return true;
+    }
+    bool setAnalogOutputDescription(const char *description)
+    {
+        (void)description;
+        return true;
+    }
+    bool setAnalogOutputResolution(float resolution)
+    {
+        (void)resolution;
+        return true;
+    }
+    bool setAnalogOutputMinMax(float min, float max)
+    {
+        (void)min;
+        (void)max;
+        return true;
+    }
+    bool addAnalogInput() { return true; }
+    bool setAnalogInputDescription(const char *description)
+    {
+        (void)description;
+        return true;
+    }
+    bool setAnalogInputResolution(float resolution)
+    {
+        (void)resolution;
+        return true;
+    }
+    bool setAnalogInputMinMax(float min, float max)
+    {
+        (void)min;
+        (void)max;
+        return true;
+    }
+    bool setAnalogInput(float value)
+    {
+        analogInput = value;
+        return true;
+    }
+    bool reportAnalogInput() { return report(); }
+    float simAnalogInput() const { return analogInput; }
+
+    void onAnalogOutputChange(void (*callback)(float)) { changeCallback = callback; }
+
+    bool setAnalogOutput(float value)
+    {
+        analogOutput = value;
+        return true;
+    }
+    bool reportAnalogOutput() { return report(); }
+    float simAnalogOutput() const { return analogOutput; }
+
+    // Attribute write as received from the coordinator
+    void simWriteAnalogOutput(float value)
+    {
+        analogOutput = value;
+        changeCallback(value);
+    }
+
+private:
+    void (*changeCallback)(float) = nullptr;
+    float analogOutput = 0;
+    float analogInput = 0;
+};
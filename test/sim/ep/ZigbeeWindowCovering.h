@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ZigbeeCore.h"
+
+enum ZigbeeWindowCoveringType
+{
+    ROLLERSHADE = 0x00,
+};
+
+class ZigbeeWindowCovering : public ZigbeeEP
+{
+public:
+    explicit ZigbeeWindowCovering(uint8_t endpoint) : ZigbeeEP(endpoint) {}
+
+    void setCoveringType(ZigbeeWindowCoveringType type) { (void)type; }
+    void setConfigStatus(bool, bool, bool, bool, bool, bool, bool) {}
+    void setMode(bool, bool, bool, bool) {}
+    void setLimits(uint16_t, uint16_t, uint16_t, uint16_t) {}
+
+    void onOpen(void (*callback)()) { openCallback = callback; }
+    void onClose(void (*callback)()) { closeCallback = callback; }
+    void onGoToLiftPercentage(void (*callback)(uint8_t)) { goToLiftCallback = callback; }
+    void onStop(void (*callback)()) { stopCallback = callback; }
+
+    bool setLiftPercentage(uint8_t percentage)
+    {
+        liftPercentage = percentage;
+        return report();
+    }
+    uint8_t simLiftPercentage() const { return liftPercentage; }
+
+    // Commands as received from the coordinator
+    void simOpen() { openCallback(); }
+    void simClose() { closeCallback(); }
+    void simStop() { stopCallback(); }
+    void simGoToLiftPercentage(uint8_t percentage) { goToLiftCallback(percentage); }
+
+private:
+    void (*openCallback)() = nullptr;
+    void (*closeCallback)() = nullptr;
+    void (*stopCallback)() = nullptr;
+    void (*goToLiftCallback)(uint8_t) = nullptr;
+    uint8_t liftPercentage = 0;
+};
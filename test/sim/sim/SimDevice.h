@@ -0,0 +1,76 @@
+#pragma once
+
+// Boots the real firmware against the simulated hardware the way setup() in main.cpp does: Zigbee
+// endpoints, the stepper driver and the state saved in NVS. Shared by the host suites that run the
+// whole device rather than a single module.
+
+#include <functional>
+
+#include <FastAccelStepper.h>
+#include <ZigbeeCore.h>
+#include "SimKernel.h"
+#include "StepperUart.h"
+#include "ZigbeeCoveringHelper.h"
+
+namespace sim
+{
+    inline bool motorRunning()
+    {
+        FastAccelStepper *stepper = activeStepper();
+        return stepper != nullptr && stepper->isRunning();
+    }
+
+    // Last position the firmware's update timer handed to updatePosition()
+    inline int32_t &updatedPosition()
+    {
+        static int32_t position = 0;
+        return position;
+    }
+
+    inline void recordPositionUpdate(int32_t position)
+    {
+        updatedPosition() = position;
+        updatePosition(position);
+    }
+
+    // Nothing the device owes the outside world is in flight: the motor has stopped, its final
+    // position has been picked up, and no Zigbee report or NVS save is waiting for its rate limit.
+    // Only then may the kernel skip ahead.
+    inline bool deviceIdle()
+    {
+        FastAccelStepper *stepper = activeStepper();
+        bool positionUpdated = stepper == nullptr || stepper->getCurrentPosition() == updatedPosition();
+        return !motorRunning() && positionUpdated && !hasPendingZigbeeReports() && !hasPendingTravelModelSave();
+    }
+
+    // Powers the device on at `nowMs`. `observe`, if set, runs after every simulated millisecond
+    // and before each skip ahead, so a harness can sample the device without missing anything.
+    inline StepperUart &bootDevice(uint64_t nowMs, std::function<void()> observe = nullptr)
+    {
+        Kernel &kernel = Kernel::instance();
+        kernel.setNow(nowMs);
+        kernel.plantTick = [observe]
+        {
+            if (FastAccelStepper *stepper = activeStepper())
+                stepper->simTick();
+            if (observe)
+                observe();
+        };
+        kernel.plantIdle = [observe]
+        {
+            if (observe)
+                observe();
+            return deviceIdle();
+        };
+
+        Zigbee.begin();
+        createAndSetupZigbeeEndpoints();
+
+        static StepperUart stepperMotor; // One device per process; a reboot is a new (forked) process
+        stepperMotor.init();
+        readAndUpdateZigbeeCoverState(stepperMotor);
+        updatedPosition() = stepperMotor.getCurrentPosition(); // Already saved
+        stepperMotor.setPositionUpdateCallback(recordPositionUpdate);
+        return stepperMotor;
+    }
+}
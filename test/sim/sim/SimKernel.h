@@ -0,0 +1,373 @@
+#pragma once
+
+// Virtual-time scheduler standing in for FreeRTOS on the host.
+//
+// Every task runs on its own thread, but only one thread (a task or the kernel itself) holds the
+// baton at any time, so firmware code sees the same run-to-block semantics as on a single-core
+// ESP32-C6. Time only moves when every task is blocked, which lets a soak run cover months of
+// virtual time in seconds.
+
+#include <cfenv>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sim
+{
+    // Thrown inside a task to unwind it (vTaskDelete(NULL)).
+    struct TaskExit
+    {
+    };
+
+    // Rough ESP-IDF sizes, used to account simulated RTOS heap usage.
+    constexpr uint32_t TCB_BYTES = 352;
+    constexpr uint32_t TIMER_BYTES = 56;
+
+    struct Task
+    {
+        std::string name;
+        void (*fn)(void *) = nullptr;
+        void *arg = nullptr;
+        uint32_t stackBytes = 0;
+        bool firmware = true; // false for harness-owned tasks (traffic generators)
+        uint64_t wakeAt = 0;
+        bool done = false;
+        std::thread thread;
+    };
+
+    struct Timer
+    {
+        std::string name;
+        uint32_t periodMs = 0;
+        bool autoReload = false;
+        void *id = nullptr;
+        void (*callback)(Timer *) = nullptr;
+        uint64_t dueAt = 0;
+        bool active = false;
+
+        uint64_t calls = 0;
+        // Callbacks that raised a floating-point exception flag. Exact float operations (converting
+        // a small integer, rounding a whole number) raise none, so this is a lower bound on the
+        // callbacks doing float maths, not proof that the rest do none.
+        uint64_t floatCalls = 0;
+    };
+
+    class Kernel
+    {
+    public:
+        static Kernel &instance()
+        {
+            static Kernel kernel;
+            return kernel;
+        }
+
+        uint64_t now() const { return nowMs; }
+        void setNow(uint64_t ms) { nowMs = ms; }
+
+        Task *createTask(void (*fn)(void *), const char *name, uint32_t stackBytes, void *arg, bool firmware = true)
+        {
+            auto task = std::make_unique<Task>();
+            task->name = name;
+            task->fn = fn;
+            task->arg = arg;
+            task->stackBytes = stackBytes;
+            task->firmware = firmware;
+            task->wakeAt = nowMs;
+
+            Task *raw = task.get();
+            raw->thread = std::thread([this, raw]
+                                      { taskEntry(raw); });
+            tasks.push_back(std::move(task));
+
+            heapBytes += stackBytes + TCB_BYTES;
+            if (heapBytes > peakHeapBytes)
+                peakHeapBytes = heapBytes;
+            uint32_t live = firmwareTaskCount();
+            if (live > peakFirmwareTasks)
+                peakFirmwareTasks = live;
+            return raw;
+        }
+
+        // Blocks the calling task for at least one tick. Must be called from a task.
+        void delay(uint32_t ms)
+        {
+            Task *self = current;
+            if (self == nullptr)
+            {
+                // Called from kernel context (timer callback): nothing to yield to.
+                return;
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            self->wakeAt = nowMs + (ms == 0 ? 1 : ms);
+            current = nullptr;
+            cv.notify_all();
+            cv.wait(lock, [&]
+                    { return current == self; });
+        }
+
+        [[noreturn]] void exitTask()
+        {
+            throw TaskExit{};
+        }
+
+        Timer *createTimer(const char *name, uint32_t periodMs, bool autoReload, void *id, void (*callback)(Timer *))
+        {
+            auto timer = std::make_unique<Timer>();
+            timer->name = name;
+            timer->periodMs = periodMs == 0 ? 1 : periodMs;
+            timer->autoReload = autoReload;
+            timer->id = id;
+            timer->callback = callback;
+            Timer *raw = timer.get();
+            timers.push_back(std::move(timer));
+
+            heapBytes += TIMER_BYTES;
+            if (heapBytes > peakHeapBytes)
+                peakHeapBytes = heapBytes;
+            return raw;
+        }
+
+        const Timer *findTimer(const char *name) const
+        {
+            for (const auto &timer : timers)
+                if (timer->name == name)
+                    return timer.get();
+            return nullptr;
+        }
+
+        void startTimer(Timer *timer)
+        {
+            timer->dueAt = nowMs + timer->periodMs;
+            timer->active = true;
+        }
+
+        uint32_t firmwareTaskCount() const
+        {
+            uint32_t count = 0;
+            for (const auto &task : tasks)
+                if (task->firmware && !task->done)
+                    ++count;
+            return count;
+        }
+
+        // Runs tasks, timers and the plant until the deadline or until stop() is called. A task may
+        // move the deadline while the kernel is running (e.g. to schedule a power cut).
+        void runUntil(uint64_t until)
+        {
+            deadline = until;
+            stopRequested = false;
+            while (!stopRequested && nowMs < deadline)
+            {
+                runReadyTasks();
+                if (stopRequested)
+                    break;
+
+                for (size_t i = 0; i < timers.size(); ++i)
+                {
+                    Timer *timer = timers[i].get();
+                    if (timer->active && timer->dueAt <= nowMs)
+                    {
+                        if (timer->autoReload)
+                            timer->dueAt += timer->periodMs;
+                        else
+                            timer->active = false;
+                        std::feclearexcept(FE_ALL_EXCEPT);
+                        timer->callback(timer);
+                        ++timer->calls;
+                        if (std::fetestexcept(FE_ALL_EXCEPT))
+                            ++timer->floatCalls;
+                    }
+                }
+
+                uint64_t next = deadline;
+                for (const auto &task : tasks)
+                    if (!task->done && task->wakeAt < next)
+                        next = task->wakeAt;
+
+                // With the motor idle and no firmware task alive, periodic timers cannot change
+                // anything, so skip straight to the next task wake-up.
+                bool quiescent = firmwareTaskCount() == 0 && (!plantIdle || plantIdle());
+                if (!quiescent)
+                {
+                    for (const auto &timer : timers)
+                        if (timer->active && timer->dueAt < next)
+                            next = timer->dueAt;
+                }
+
+                if (next <= nowMs)
+                    continue;
+
+                if (quiescent)
+                {
+                    nowMs = next;
+                    for (auto &timer : timers)
+                        if (timer->active && timer->dueAt < nowMs)
+                            timer->dueAt = nowMs + timer->periodMs;
+                    continue;
+                }
+
+                while (nowMs < next)
+                {
+                    ++nowMs;
+                    if (plantTick)
+                        plantTick();
+                }
+            }
+        }
+
+        void stop() { stopRequested = true; }
+        void setDeadline(uint64_t until) { deadline = until; }
+        uint64_t getDeadline() const { return deadline; }
+
+        uint64_t heapBytes = 0;
+        uint64_t peakHeapBytes = 0;
+        uint32_t peakFirmwareTasks = 0;
+
+        std::function<void()> plantTick; // advances the simulated hardware by one millisecond
+        std::function<bool()> plantIdle;
+
+    private:
+        Kernel() = default;
+
+        void taskEntry(Task *task)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]
+                        { return current == task; });
+            }
+            try
+            {
+                task->fn(task->arg);
+            }
+            catch (const TaskExit &)
+            {
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            task->done = true;
+            current = nullptr;
+            cv.notify_all();
+        }
+
+        void resume(Task *task)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            current = task;
+            cv.notify_all();
+            cv.wait(lock, [&]
+                    { return current == nullptr; });
+        }
+
+        void runReadyTasks()
+        {
+            bool ran = true;
+            while (ran && !stopRequested)
+            {
+                ran = false;
+                for (size_t i = 0; i < tasks.size(); ++i)
+                {
+                    Task *task = tasks[i].get();
+                    if (!task->done && task->wakeAt <= nowMs)
+                    {
+                        resume(task);
+                        ran = true;
+                    }
+                }
+                reapFinishedTasks();
+            }
+        }
+
+        void reapFinishedTasks()
+        {
+            for (auto it = tasks.begin(); it != tasks.end();)
+            {
+                if ((*it)->done)
+                {
+                    (*it)->thread.join();
+                    heapBytes -= (*it)->stackBytes + TCB_BYTES;
+                    it = tasks.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+
+        uint64_t nowMs = 0;
+        uint64_t deadline = 0;
+        bool stopRequested = false;
+        std::vector<std::unique_ptr<Task>> tasks;
+        std::vector<std::unique_ptr<Timer>> timers;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        Task *current = nullptr;
+    };
+}
+
+// FreeRTOS API surface used by the firmware.
+
+typedef sim::Task *TaskHandle_t;
+typedef sim::Timer *TimerHandle_t;
+typedef void (*TaskFunction_t)(void *);
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t);
+typedef int BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(ms))
+
+// Only one simulated thread runs at a time, so a critical section has nothing to exclude.
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+inline BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *param,
+                              UBaseType_t priority, TaskHandle_t *handle)
+{
+    (void)priority;
+    TaskHandle_t task = sim::Kernel::instance().createTask(fn, name, stackDepth, param);
+    if (handle != nullptr)
+        *handle = task;
+    return pdPASS;
+}
+
+inline void vTaskDelete(TaskHandle_t task)
+{
+    // The firmware only ever deletes itself.
+    (void)task;
+    sim::Kernel::instance().exitTask();
+}
+
+inline void vTaskDelay(TickType_t ticks)
+{
+    sim::Kernel::instance().delay(ticks);
+}
+
+inline TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t autoReload, void *id,
+                                  TimerCallbackFunction_t callback)
+{
+    return sim::Kernel::instance().createTimer(name, period, autoReload != 0, id, callback);
+}
+
+inline BaseType_t xTimerStart(TimerHandle_t timer, TickType_t)
+{
+    sim::Kernel::instance().startTimer(timer);
+    return pdPASS;
+}
+
+inline void *pvTimerGetTimerID(TimerHandle_t timer)
+{
+    return timer->id;
+}
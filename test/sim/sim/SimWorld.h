@@ -0,0 +1,84 @@
+#pragma once
+
+// State that outlives a simulated power cut: the physical blind, NVS flash and fault injection.
+//
+// The soak harness maps one World into memory shared with each forked "MCU" process, so a power
+// cut is just killing that process. Everything the firmware keeps in RAM (statics, tasks, the
+// stepper's step counter) is lost, exactly as on the real device.
+
+#include <cstdint>
+#include <cstring>
+
+namespace sim
+{
+    constexpr uint32_t NVS_ENTRIES = 32;
+    constexpr uint32_t NVS_MAX_VALUE_BYTES = 128;
+
+    struct NvsEntry
+    {
+        bool used;
+        char ns[16];
+        char key[16];
+        uint16_t length;
+        uint8_t data[NVS_MAX_VALUE_BYTES];
+    };
+
+    struct World
+    {
+        uint64_t nowMs;
+
+        // Plant, in motor steps. Step 0 is where the firmware believed 0 was at first boot.
+        double physicalSteps;
+        double hardStopSteps; // top end stop the homing routine runs into
+        bool blocked;         // rotor is pushing against the end stop this tick
+
+        // Fault injection
+        uint64_t spuriousDiagAt; // next tick at which DIAG reads high without a stall
+        uint64_t uartErrorUntil; // driver UART reads return 0 and writes are dropped until then
+
+        // NVS
+        NvsEntry nvs[NVS_ENTRIES];
+        uint64_t nvsPuts;   // put*() calls
+        uint64_t nvsWrites; // put*() calls that changed the stored value
+    };
+
+    inline World *&worldPtr()
+    {
+        static World *world = nullptr;
+        return world;
+    }
+
+    // Falls back to a process-local World when no harness has installed a shared one.
+    inline World &world()
+    {
+        World *&world = worldPtr();
+        if (world == nullptr)
+        {
+            static World local{};
+            world = &local;
+        }
+        return *world;
+    }
+
+    inline NvsEntry *nvsFind(const char *ns, const char *key, bool create)
+    {
+        World &w = world();
+        for (NvsEntry &entry : w.nvs)
+            if (entry.used && strncmp(entry.ns, ns, sizeof(entry.ns)) == 0 && strncmp(entry.key, key, sizeof(entry.key)) == 0)
+                return &entry;
+        if (!create)
+            return nullptr;
+        for (NvsEntry &entry : w.nvs)
+        {
+            if (!entry.used)
+            {
+                entry.used = true;
+                strncpy(entry.ns, ns, sizeof(entry.ns) - 1);
+                strncpy(entry.key, key, sizeof(entry.key) - 1);
+                entry.length = 0;
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+}
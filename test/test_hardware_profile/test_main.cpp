@@ -0,0 +1,64 @@
+// Host tests for the compile-time hardware profiles: the integer maths must match the float
+// formulas the firmware used before, so existing devices keep their calibration.
+
+#include <unity.h>
+
+#include <cfenv>
+#include <cmath>
+
+#include <Arduino.h>
+#include "HardwareProfile.h"
+
+// Everything derived from a profile is a compile-time constant
+static_assert(CurtainV3::tstep(7500) == 51, "TSTEP folds at compile time");
+static_assert(CurtainV3::tcoolthrs(5000) == 98, "TCOOLTHRS folds at compile time");
+static_assert(CurtainV3::MAX_POSITION == 400 * 1188, "limits fold at compile time");
+
+void setUp() {}
+void tearDown() {}
+
+void test_steps_per_cm_matches_original_constant()
+{
+    // 2.0cm diameter spool, 200 steps per round x 8 microsteps x 4.666666666666:1 gear ratio
+    const uint32_t original = (200 * 8 * 4.667) / (2.0 * PI);
+    TEST_ASSERT_EQUAL_UINT32(original, CurtainV3::STEPS_PER_CM);
+    TEST_ASSERT_EQUAL_UINT32(792, CurtainV3LongDrop::STEPS_PER_CM);
+}
+
+template <typename Profile>
+static void checkTstepAgainstFloat()
+{
+    for (uint32_t speed = 1; speed <= Profile::MAX_SPEED; speed += 7)
+    {
+        int tstep = (12000000 / (speed * 1.0f / Profile::MICROSTEPS * 256)) + 1;
+        TEST_ASSERT_UINT32_WITHIN(1, tstep, Profile::tstep(speed));
+        TEST_ASSERT_UINT32_WITHIN(2, static_cast<uint32_t>(tstep * 1.3), Profile::tcoolthrs(speed));
+    }
+}
+
+void test_tstep_matches_float_formula()
+{
+    checkTstepAgainstFloat<CurtainV3>();
+    checkTstepAgainstFloat<CurtainV3LongDrop>();
+    // The speeds the firmware uses by default come out exactly as before
+    TEST_ASSERT_EQUAL_UINT32(76, CurtainV3::tstep(5000));
+    TEST_ASSERT_EQUAL_UINT32(66, CurtainV3::tcoolthrs(7500));
+}
+
+void test_runtime_conversions_do_no_float_maths()
+{
+    volatile uint32_t sink = 0;
+    std::feclearexcept(FE_ALL_EXCEPT);
+    for (uint32_t speed = 1; speed <= CurtainV3::MAX_SPEED; speed++)
+        sink = sink + CurtainV3::tstep(speed) + CurtainV3::tcoolthrs(speed);
+    TEST_ASSERT_EQUAL(0, std::fetestexcept(FE_ALL_EXCEPT));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_steps_per_cm_matches_original_constant);
+    RUN_TEST(test_tstep_matches_float_formula);
+    RUN_TEST(test_runtime_conversions_do_no_float_maths);
+    return UNITY_END();
+}
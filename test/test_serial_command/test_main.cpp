@@ -0,0 +1,402 @@
+// Host tests for the framed serial control protocol, driven through a simulated loop() task.
+
+#include <unity.h>
+
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include <Arduino.h>
+#include <FastAccelStepper.h>
+#include <Preferences.h>
+#include <ZigbeeCore.h>
+#include <ep/ZigbeeAnalog.h>
+#include <sim/SimDevice.h>
+#include "StepperUart.h"
+#include "ZigbeeCoveringHelper.h"
+#include "SerialCommand.h"
+#include "ZigbeePublisher.h"
+
+class FakeStream : public Stream
+{
+public:
+    int available() override { return static_cast<int>(input.size() - inputPos); }
+    int read() override { return inputPos < input.size() ? static_cast<uint8_t>(input[inputPos++]) : -1; }
+    size_t write(const uint8_t *data, size_t len) override
+    {
+        output.append(reinterpret_cast<const char *>(data), len);
+        return len;
+    }
+
+    void send(const std::string &data) { input += data; }
+
+    // Returns the complete lines written since the last call.
+    std::vector<std::string> lines()
+    {
+        std::vector<std::string> result;
+        size_t start = 0;
+        for (size_t end = output.find('\n'); end != std::string::npos; end = output.find('\n', start))
+        {
+            result.push_back(output.substr(start, end - start));
+            start = end + 1;
+        }
+        output.erase(0, start);
+        return result;
+    }
+
+private:
+    std::string input;
+    size_t inputPos = 0;
+    std::string output;
+};
+
+static FakeStream stream;
+static StepperUart *stepperMotor = nullptr;
+static SerialCommand *serialCommand = nullptr;
+
+static void loopTask(void *)
+{
+    while (true)
+    {
+        serialCommand->poll();
+        vTaskDelay(portTICK_PERIOD_MS * 5);
+    }
+}
+
+static void runFor(uint32_t ms)
+{
+    sim::Kernel &kernel = sim::Kernel::instance();
+    kernel.runUntil(kernel.now() + ms);
+}
+
+// Strips the leading timestamp so responses can be compared exactly.
+static std::string untimed(const std::string &line)
+{
+    size_t space = line.find(' ');
+    return space == std::string::npos ? line : line.substr(space + 1);
+}
+
+static bool isResponse(const std::string &line)
+{
+    return !line.empty() && isdigit(static_cast<unsigned char>(line[0]));
+}
+
+static std::vector<std::string> responses()
+{
+    std::vector<std::string> result;
+    for (const std::string &line : stream.lines())
+        if (isResponse(line))
+            result.push_back(untimed(line));
+    return result;
+}
+
+static void bootDevice()
+{
+    sim::Kernel &kernel = sim::Kernel::instance();
+    stepperMotor = &sim::bootDevice(0);
+
+    serialCommand = new SerialCommand(stream, *stepperMotor);
+    kernel.createTask(loopTask, "loopTask", 8192, nullptr, false);
+    runFor(ZIGBEE_BOOT_JITTER_MS + ZIGBEE_PUBLISH_INTERVAL_MS); // Past the boot hold on reports
+    stream.lines();
+}
+
+static void waitUntilSettled()
+{
+    runFor(10); // Let loop() pick up any command sent just before
+    for (int i = 0; i < 600 && isCoverMoving(); i++)
+        runFor(100);
+    runFor(100); // Let loop() see the stop and report it
+}
+
+// The query's value for `key`, e.g. "errs" in "... errs=5 ..."
+static long field(const std::string &line, const std::string &key)
+{
+    size_t at = line.find(" " + key + "=");
+    TEST_ASSERT_TRUE(at != std::string::npos);
+    return at == std::string::npos ? -1 : strtol(line.c_str() + at + key.size() + 2, nullptr, 10);
+}
+
+static std::string query(const std::string &command)
+{
+    stream.send(command + "\n");
+    runFor(10);
+    std::vector<std::string> lines = responses();
+    TEST_ASSERT_EQUAL(1, lines.size());
+    return lines.empty() ? std::string() : lines[0];
+}
+
+// Every test starts from the same settled device: default settings and the cover at the top limit.
+// Command counters and travel stats keep counting, so tests compare them against their own baseline.
+void setUp()
+{
+    setCoverSpeed(7500.0f);
+    setCoverStallSensitivity(130);
+    setCoverBottomLimit(100);
+    setCoverTopLimit(10); // Both move the cover; the top limit is commanded last
+    waitUntilSettled();
+    stream.lines();
+}
+
+void tearDown() {}
+
+void test_ping_echoes_tag_and_timestamp()
+{
+    runFor(100);
+    unsigned long sentAt = millis();
+    stream.send("#1 ping\n");
+    runFor(10);
+
+    std::vector<std::string> lines = stream.lines();
+    TEST_ASSERT_EQUAL(1, lines.size());
+    unsigned long stamp = strtoul(lines[0].c_str(), nullptr, 10);
+    TEST_ASSERT_TRUE(stamp >= sentAt && stamp <= sentAt + 10);
+    TEST_ASSERT_EQUAL_STRING("#1 ok", untimed(lines[0]).c_str());
+}
+
+void test_untagged_commands_use_dash()
+{
+    stream.send("ping\n");
+    runFor(10);
+    std::vector<std::string> lines = responses();
+    TEST_ASSERT_EQUAL(1, lines.size());
+    TEST_ASSERT_EQUAL_STRING("- ok", lines[0].c_str());
+}
+
+void test_batch_runs_in_order_and_reports_stop()
+{
+    stream.send("#7 top 10; bottom 100;goto 50\n");
+    runFor(30000);
+
+    std::vector<std::string> lines = responses();
+    TEST_ASSERT_EQUAL(4, lines.size());
+    TEST_ASSERT_EQUAL_STRING("#7 ok", lines[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("#7 ok", lines[1].c_str());
+    TEST_ASSERT_EQUAL(0, lines[2].find("#7 ok target="));
+    TEST_ASSERT_EQUAL(0, lines[3].find("- evt stopped pos="));
+
+    CoverState state = getCoverState();
+    TEST_ASSERT_FALSE(state.running);
+    TEST_ASSERT_FLOAT_WITHIN(0.5, 50.0, state.liftPercentage);
+}
+
+void test_travel_query()
+{
+    std::string before = query("#9 travel");
+    TEST_ASSERT_EQUAL(0, before.find("#9 ok eta=0 "));
+    stream.send("goto 50\n");
+    waitUntilSettled();
+    responses();
+
+    std::string after = query("#9 travel");
+    TEST_ASSERT_EQUAL(field(before, "up_n"), field(after, "up_n"));
+    TEST_ASSERT_EQUAL(field(before, "down_n") + 1, field(after, "down_n"));
+}
+
+// Whether the learned travel model in NVS matches the one in RAM.
+static bool travelModelSaved()
+{
+    TravelModelParams saved = {};
+    Preferences prefs;
+    prefs.begin("ZBCover");
+    bool found = prefs.getBytes("travelModel", &saved, sizeof(saved)) == sizeof(saved);
+    prefs.end();
+    const TravelModelParams &params = getTravelModel().getParams();
+    return found && memcmp(saved.efficiency, params.efficiency, sizeof(params.efficiency)) == 0 &&
+           memcmp(saved.overheadMs, params.overheadMs, sizeof(params.overheadMs)) == 0;
+}
+
+void test_travel_model_saves_are_rate_limited()
+{
+    const uint32_t saveIntervalMs = 60000; // TRAVEL_MODEL_SAVE_MS
+    runFor(saveIntervalMs);
+    TEST_ASSERT_FALSE(hasPendingTravelModelSave());
+
+    // The first arrival after a quiet minute is saved at once
+    stream.send("goto 60\n");
+    waitUntilSettled();
+    TEST_ASSERT_FALSE(hasPendingTravelModelSave());
+    TEST_ASSERT_TRUE(travelModelSaved());
+
+    // Moves right after it only update the model in RAM
+    stream.send("goto 30\n");
+    waitUntilSettled();
+    stream.send("goto 60\n");
+    waitUntilSettled();
+    TEST_ASSERT_TRUE(hasPendingTravelModelSave());
+    TEST_ASSERT_FALSE(travelModelSaved());
+
+    runFor(saveIntervalMs);
+    TEST_ASSERT_FALSE(hasPendingTravelModelSave());
+    TEST_ASSERT_TRUE(travelModelSaved());
+    responses();
+}
+
+void test_state_query()
+{
+    stream.send("goto 50\n");
+    waitUntilSettled();
+    responses();
+
+    std::string state = query("#2 state");
+    TEST_ASSERT_EQUAL(0, state.find("#2 ok pos="));
+    TEST_ASSERT_TRUE(state.find(" running=0 lift=50.0 top=10 bottom=100 speed=7500 sgthrs=130 eta=0") != std::string::npos);
+}
+
+void test_upward_move_reports_final_target_once()
+{
+    stream.send("goto 60\n");
+    waitUntilSettled();
+    responses();
+
+    stream.send("#10 goto 20\n");
+    runFor(30000);
+
+    std::vector<std::string> lines = responses();
+    TEST_ASSERT_EQUAL(2, lines.size()); // No event for the pause at the overshoot point
+    TEST_ASSERT_EQUAL(0, lines[0].find("#10 ok target="));
+    long target = strtol(lines[0].c_str() + strlen("#10 ok target="), nullptr, 10);
+    TEST_ASSERT_EQUAL(0, lines[1].find("- evt stopped pos=" + std::to_string(target) + " "));
+    TEST_ASSERT_EQUAL_INT32(target, stepperMotor->getCurrentPosition());
+}
+
+void test_home_does_not_block_and_stop_aborts_it()
+{
+    stream.send("goto 50\n");
+    waitUntilSettled();
+    responses();
+
+    int32_t before = stepperMotor->getCurrentPosition();
+    stream.send("#11 home\n");
+    runFor(10);
+    std::vector<std::string> lines = responses();
+    TEST_ASSERT_EQUAL(1, lines.size());
+    TEST_ASSERT_EQUAL_STRING("#11 ok", lines[0].c_str());
+    TEST_ASSERT_TRUE(getCoverState().running);
+
+    runFor(500);
+    stream.send("#12 ping; stop\n");
+    runFor(5000);
+    lines = responses();
+    TEST_ASSERT_EQUAL(3, lines.size()); // One event for the aborted homing, nothing after it
+    if (lines.size() == 3)
+    {
+        TEST_ASSERT_EQUAL_STRING("#12 ok", lines[0].c_str());
+        TEST_ASSERT_EQUAL_STRING("#12 ok", lines[1].c_str());
+        TEST_ASSERT_EQUAL(0, lines[2].find("- evt stopped pos="));
+    }
+    // Aborted before reaching the end stop, so the position was not reset and nothing moved on
+    int32_t after = stepperMotor->getCurrentPosition();
+    TEST_ASSERT_TRUE(after < before && after > 0);
+    TEST_ASSERT_FALSE(getCoverState().running);
+
+    stream.send("#13 goto 20\n");
+    runFor(30000);
+    TEST_ASSERT_EQUAL(2, responses().size());
+}
+
+void test_line_split_across_polls()
+{
+    stream.send("#3 pi");
+    runFor(20);
+    TEST_ASSERT_EQUAL(0, responses().size());
+    stream.send("ng\r\n");
+    runFor(10);
+    std::vector<std::string> lines = responses();
+    TEST_ASSERT_EQUAL(1, lines.size());
+    TEST_ASSERT_EQUAL_STRING("#3 ok", lines[0].c_str());
+}
+
+void test_errors()
+{
+    stream.send("#4 fly; goto; goto 101; goto 5x; sgthrs 10 20\n");
+    runFor(10);
+    std::vector<std::string> lines = responses();
+    TEST_ASSERT_EQUAL(5, lines.size());
+    TEST_ASSERT_EQUAL_STRING("#4 err unknown command", lines[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("#4 err expected 0-100", lines[1].c_str());
+    TEST_ASSERT_EQUAL_STRING("#4 err expected 0-100", lines[2].c_str());
+    TEST_ASSERT_EQUAL_STRING("#4 err expected 0-100", lines[3].c_str());
+    TEST_ASSERT_EQUAL_STRING("#4 err too many arguments", lines[4].c_str());
+}
+
+void test_overlong_line_is_rejected()
+{
+    stream.send(std::string(SERIAL_COMMAND_MAX_LINE + 10, 'x') + "\n#5 ping\n");
+    runFor(10);
+    std::vector<std::string> lines = responses();
+    TEST_ASSERT_EQUAL(2, lines.size());
+    TEST_ASSERT_EQUAL_STRING("- err line too long", lines[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("#5 ok", lines[1].c_str());
+}
+
+void test_settings_are_shared_with_zigbee()
+{
+    stream.send("#6 speed 2400; sgthrs 120\n");
+    runFor(ZIGBEE_PUBLISH_INTERVAL_MS + 10); // Reports go out on the next publish tick
+    TEST_ASSERT_EQUAL(2, responses().size());
+
+    TEST_ASSERT_EQUAL_FLOAT(2400.0f, static_cast<ZigbeeAnalog *>(Zigbee.simEndpoint(15))->simAnalogOutput());
+    TEST_ASSERT_EQUAL_FLOAT(120.0f, static_cast<ZigbeeAnalog *>(Zigbee.simEndpoint(12))->simAnalogOutput());
+    TEST_ASSERT_EQUAL_FLOAT(2400.0f, stepperMotor->getSpeed());
+    TEST_ASSERT_EQUAL_UINT8(120, stepperMotor->getSGTHRS());
+}
+
+void test_legacy_single_character_commands()
+{
+    stream.send("#14 3; +; -; -\n");
+    runFor(ZIGBEE_PUBLISH_INTERVAL_MS + 10);
+    std::vector<std::string> lines = responses();
+    TEST_ASSERT_EQUAL(4, lines.size());
+    TEST_ASSERT_EQUAL_STRING("#14 ok speed=5000", lines[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("#14 ok sgthrs=140", lines[1].c_str());
+    TEST_ASSERT_EQUAL_STRING("#14 ok sgthrs=130", lines[2].c_str());
+    TEST_ASSERT_EQUAL_STRING("#14 ok sgthrs=120", lines[3].c_str());
+    TEST_ASSERT_EQUAL(5000, stepperMotor->getSpeed());
+    TEST_ASSERT_EQUAL_UINT8(120, stepperMotor->getSGTHRS());
+
+    stream.send("+; +; +\n"); // Clamped at the register's maximum
+    runFor(10);
+    lines = responses();
+    TEST_ASSERT_EQUAL(3, lines.size());
+    TEST_ASSERT_EQUAL_STRING("- ok sgthrs=144", lines[2].c_str());
+}
+
+void test_metrics_query()
+{
+    std::string before = query("#8 metrics");
+    TEST_ASSERT_EQUAL(0, before.find("#8 ok uptime="));
+
+    stream.send("fly; ping\n" + std::string(SERIAL_COMMAND_MAX_LINE + 10, 'x') + "\n");
+    runFor(10);
+    TEST_ASSERT_EQUAL(3, responses().size());
+
+    std::string after = query("#8 metrics");
+    TEST_ASSERT_EQUAL(field(before, "cmds") + 3, field(after, "cmds")); // fly, ping and this query
+    TEST_ASSERT_EQUAL(field(before, "errs") + 1, field(after, "errs"));
+    TEST_ASSERT_EQUAL(field(before, "overflows") + 1, field(after, "overflows"));
+}
+
+int main(int argc, char **argv)
+{
+    bootDevice();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_ping_echoes_tag_and_timestamp);
+    RUN_TEST(test_untagged_commands_use_dash);
+    RUN_TEST(test_batch_runs_in_order_and_reports_stop);
+    RUN_TEST(test_travel_query);
+    RUN_TEST(test_travel_model_saves_are_rate_limited);
+    RUN_TEST(test_state_query);
+    RUN_TEST(test_upward_move_reports_final_target_once);
+    RUN_TEST(test_home_does_not_block_and_stop_aborts_it);
+    RUN_TEST(test_line_split_across_polls);
+    RUN_TEST(test_errors);
+    RUN_TEST(test_overlong_line_is_rejected);
+    RUN_TEST(test_settings_are_shared_with_zigbee);
+    RUN_TEST(test_legacy_single_character_commands);
+    RUN_TEST(test_metrics_query);
+    int result = UNITY_END();
+    fflush(stdout);
+    _exit(result); // Simulated tasks never return; skip joining their threads
+}
@@ -0,0 +1,207 @@
+// Host tests for the learned travel model.
+
+#include <unity.h>
+
+#include <algorithm>
+
+#include <Arduino.h>
+#include "TravelModel.h"
+
+static const int32_t TOP = 10000;
+static const int32_t BOTTOM = 90000;
+static const float SPEED = 5000.0f;
+
+static TravelModel model;
+
+// Simulated blind: moving down runs at 90% of the commanded speed, moving up at 60% in the lower
+// half of the travel and 80% in the upper half. Every trip starts 300 ms late.
+static float actualEfficiency(TravelDirection direction, int32_t position)
+{
+    if (direction == TRAVEL_DOWN)
+        return 0.9f;
+    return position > (TOP + BOTTOM) / 2 ? 0.6f : 0.8f;
+}
+
+// Drives one trip through the model, sampling every 100 ms like the firmware. Returns the actual
+// duration in ms.
+static uint32_t runTrip(uint32_t &now, int32_t from, int32_t to)
+{
+    const uint32_t startDelayMs = 300;
+    TravelDirection direction = to < from ? TRAVEL_UP : TRAVEL_DOWN;
+    model.beginTrip(now, from, to, SPEED);
+
+    uint32_t start = now;
+    double position = from;
+    while (true)
+    {
+        now++;
+        if (now - start > startDelayMs)
+        {
+            double step = SPEED * actualEfficiency(direction, static_cast<int32_t>(position)) / 1000.0;
+            position = direction == TRAVEL_DOWN ? std::min<double>(position + step, to) : std::max<double>(position - step, to);
+        }
+        bool running = static_cast<int32_t>(position) != to;
+        if (now % 100 == 0 || !running)
+        {
+            if (model.sample(now, static_cast<int32_t>(position), running))
+                return now - start;
+        }
+    }
+}
+
+void setUp()
+{
+    model.reset();
+    model.setRange(TOP, BOTTOM);
+}
+
+void tearDown() {}
+
+void test_untrained_model_uses_commanded_speed()
+{
+    TEST_ASSERT_EQUAL_UINT32(16000, model.predictDurationMs(TOP, BOTTOM, SPEED));
+    TEST_ASSERT_EQUAL_UINT32(16000, model.predictDurationMs(BOTTOM, TOP, SPEED));
+    TEST_ASSERT_EQUAL_UINT32(0, model.predictDurationMs(TOP, TOP, SPEED));
+    TEST_ASSERT_EQUAL_UINT32(8000, model.predictDurationMs(TOP, BOTTOM, SPEED * 2));
+}
+
+void test_learns_speed_per_direction_and_position()
+{
+    uint32_t now = 0;
+    for (int i = 0; i < 30; i++)
+    {
+        runTrip(now, TOP, BOTTOM);
+        runTrip(now, BOTTOM, TOP);
+    }
+
+    uint32_t downActual = runTrip(now, TOP, BOTTOM);
+    uint32_t upActual = runTrip(now, BOTTOM, TOP);
+    TEST_ASSERT_UINT32_WITHIN(downActual / 50, downActual, model.predictDurationMs(TOP, BOTTOM, SPEED));
+    TEST_ASSERT_UINT32_WITHIN(upActual / 50, upActual, model.predictDurationMs(BOTTOM, TOP, SPEED));
+
+    // Partial trips in each half of the travel see different up speeds
+    int32_t middle = (TOP + BOTTOM) / 2;
+    uint32_t lowerHalf = runTrip(now, BOTTOM, middle);
+    uint32_t upperHalf = runTrip(now, middle, TOP);
+    TEST_ASSERT_TRUE(lowerHalf > upperHalf);
+    TEST_ASSERT_UINT32_WITHIN(lowerHalf / 50, lowerHalf, model.predictDurationMs(BOTTOM, middle, SPEED));
+    TEST_ASSERT_UINT32_WITHIN(upperHalf / 50, upperHalf, model.predictDurationMs(middle, TOP, SPEED));
+}
+
+void test_error_stats_track_accuracy()
+{
+    uint32_t now = 0;
+    runTrip(now, TOP, BOTTOM);
+    const TravelErrorStats &down = model.getErrorStats(TRAVEL_DOWN);
+    TEST_ASSERT_EQUAL_UINT32(1, down.trips);
+    TEST_ASSERT_TRUE(down.meanErrorMs > 1000); // Slower than the untrained prediction
+    float firstError = down.maxAbsErrorMs;
+
+    for (int i = 0; i < 30; i++)
+    {
+        runTrip(now, BOTTOM, TOP);
+        runTrip(now, TOP, BOTTOM);
+    }
+    TEST_ASSERT_EQUAL_UINT32(31, down.trips);
+    TEST_ASSERT_EQUAL_UINT32(30, model.getErrorStats(TRAVEL_UP).trips);
+    TEST_ASSERT_EQUAL_FLOAT(firstError, down.maxAbsErrorMs);
+    TEST_ASSERT_TRUE(down.meanAbsErrorMs < firstError / 4);
+}
+
+void test_cancelled_trip_is_not_recorded()
+{
+    model.beginTrip(0, TOP, BOTTOM, SPEED);
+    TEST_ASSERT_TRUE(model.isTripActive());
+    model.sample(100, TOP + 300, true);
+    model.cancelTrip();
+    TEST_ASSERT_FALSE(model.sample(200, BOTTOM, false));
+    TEST_ASSERT_EQUAL_UINT32(0, model.getErrorStats(TRAVEL_DOWN).trips);
+}
+
+void test_predicted_position_follows_trajectory()
+{
+    model.beginTrip(1000, BOTTOM, TOP, SPEED);
+    TEST_ASSERT_EQUAL_INT32(BOTTOM, model.predictedPosition(1000));
+    TEST_ASSERT_EQUAL_INT32((TOP + BOTTOM) / 2, model.predictedPosition(1000 + 8000));
+    TEST_ASSERT_EQUAL_INT32(TOP, model.predictedPosition(1000 + 20000));
+    TEST_ASSERT_EQUAL_UINT32(6000, model.remainingMs(1000 + 10000));
+    TEST_ASSERT_EQUAL_UINT32(0, model.remainingMs(1000 + 20000));
+    TEST_ASSERT_EQUAL_UINT32(4000, model.overdueMs(1000 + 20000));
+}
+
+void test_replan_restarts_estimate_from_actual_position()
+{
+    model.beginTrip(0, TOP, BOTTOM, SPEED);
+    // Only a quarter of the way after half the predicted time
+    model.replan(8000, TOP + (BOTTOM - TOP) / 4);
+    TEST_ASSERT_EQUAL_UINT32(12000, model.remainingMs(8000));
+    TEST_ASSERT_EQUAL_INT32(TOP + (BOTTOM - TOP) / 4, model.predictedPosition(8000));
+}
+
+void test_params_round_trip_and_validation()
+{
+    uint32_t now = 0;
+    for (int i = 0; i < 5; i++)
+        runTrip(now, TOP, BOTTOM);
+    TravelModelParams learned = model.getParams();
+    uint32_t predicted = model.predictDurationMs(TOP, BOTTOM, SPEED);
+
+    model.reset();
+    TEST_ASSERT_TRUE(model.setParams(learned));
+    TEST_ASSERT_EQUAL_UINT32(predicted, model.predictDurationMs(TOP, BOTTOM, SPEED));
+
+    TravelModelParams corrupt = learned;
+    corrupt.version++;
+    TEST_ASSERT_FALSE(model.setParams(corrupt));
+    corrupt = learned;
+    corrupt.efficiency[TRAVEL_UP][3] = 0.0f;
+    TEST_ASSERT_FALSE(model.setParams(corrupt));
+    corrupt = learned;
+    corrupt.overheadMs[TRAVEL_DOWN] = NAN;
+    TEST_ASSERT_FALSE(model.setParams(corrupt));
+}
+
+void test_stats_round_trip_and_validation()
+{
+    uint32_t now = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        runTrip(now, TOP, BOTTOM);
+        runTrip(now, BOTTOM, TOP);
+    }
+    TravelModelStats learned = model.getStats();
+
+    model.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, model.getErrorStats(TRAVEL_UP).trips);
+    TEST_ASSERT_TRUE(model.setStats(learned));
+    TEST_ASSERT_EQUAL_UINT32(5, model.getErrorStats(TRAVEL_UP).trips);
+    TEST_ASSERT_EQUAL_FLOAT(learned.direction[TRAVEL_DOWN].meanAbsErrorMs, model.getErrorStats(TRAVEL_DOWN).meanAbsErrorMs);
+
+    // Restored stats keep accumulating
+    runTrip(now, TOP, BOTTOM);
+    TEST_ASSERT_EQUAL_UINT32(6, model.getErrorStats(TRAVEL_DOWN).trips);
+
+    TravelModelStats corrupt = learned;
+    corrupt.version++;
+    TEST_ASSERT_FALSE(model.setStats(corrupt));
+    corrupt = learned;
+    corrupt.direction[TRAVEL_UP].meanAbsErrorMs = NAN;
+    TEST_ASSERT_FALSE(model.setStats(corrupt));
+    corrupt = learned;
+    corrupt.direction[TRAVEL_DOWN].maxAbsErrorMs = -1.0f;
+    TEST_ASSERT_FALSE(model.setStats(corrupt));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_untrained_model_uses_commanded_speed);
+    RUN_TEST(test_learns_speed_per_direction_and_position);
+    RUN_TEST(test_error_stats_track_accuracy);
+    RUN_TEST(test_cancelled_trip_is_not_recorded);
+    RUN_TEST(test_predicted_position_follows_trajectory);
+    RUN_TEST(test_replan_restarts_estimate_from_actual_position);
+    RUN_TEST(test_params_round_trip_and_validation);
+    RUN_TEST(test_stats_round_trip_and_validation);
+    return UNITY_END();
+}
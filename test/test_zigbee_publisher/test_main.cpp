@@ -0,0 +1,455 @@
+// Host tests for batched Zigbee attribute publication: the publisher on its own, then the real
+// firmware booted against the fake Zigbee endpoints, counting frames per boot and per move.
+//
+// Each device boot runs in a forked process sharing one World, so NVS survives between boots like
+// it does across a power cycle. Every test starts from blank flash.
+
+#include <unity.h>
+
+#include <new>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <Arduino.h>
+#include <FastAccelStepper.h>
+#include <Preferences.h>
+#include <ZigbeeCore.h>
+#include <ep/ZigbeeWindowCovering.h>
+#include <ep/ZigbeeAnalog.h>
+#include <sim/SimDevice.h>
+#include "StepperUart.h"
+#include "ZigbeeCoveringHelper.h"
+#include "ZigbeePublisher.h"
+
+// --- Publisher ---
+
+static int applies = 0;
+static int32_t lastApplied = 0;
+static int reports = 0;
+static int32_t lastReported = 0;
+static bool reportSucceeds = true;
+static void (*duringReport)() = nullptr; // Stands in for another task running while a report is sent
+
+static bool fakeApply(int32_t value)
+{
+    applies++;
+    lastApplied = value;
+    return true;
+}
+
+static bool fakeReport(int32_t value)
+{
+    if (!reportSucceeds)
+        return false;
+    reports++;
+    lastReported = value;
+    if (duringReport != nullptr)
+    {
+        void (*interleaved)() = duringReport;
+        duringReport = nullptr;
+        interleaved();
+    }
+    return true;
+}
+
+static ZigbeePublisher publisher;
+
+struct Shared;
+static Shared *shared = nullptr;
+static void resetDevice();
+
+void setUp()
+{
+    publisher = ZigbeePublisher();
+    publisher.attach(ZB_ATTR_SPEED, fakeApply, fakeReport, 1, 1000, true);
+    publisher.attach(ZB_ATTR_ETA, nullptr, fakeReport, 100, 0, false); // ms, at 0.1 s
+    applies = 0;
+    lastApplied = 0;
+    reports = 0;
+    lastReported = 0;
+    reportSucceeds = true;
+    duringReport = nullptr;
+    resetDevice();
+}
+
+void tearDown() {}
+
+void test_updates_between_flushes_coalesce()
+{
+    publisher.set(ZB_ATTR_SPEED, 1000);
+    publisher.set(ZB_ATTR_SPEED, 2000);
+    publisher.set(ZB_ATTR_SPEED, 3000);
+    TEST_ASSERT_TRUE(publisher.hasPending());
+    TEST_ASSERT_TRUE(publisher.flush(0));
+    TEST_ASSERT_EQUAL(1, reports);
+    TEST_ASSERT_EQUAL(3000, lastReported);
+    TEST_ASSERT_FALSE(publisher.hasPending());
+}
+
+void test_unchanged_values_are_skipped()
+{
+    publisher.set(ZB_ATTR_ETA, 12300);
+    publisher.flush(0);
+    publisher.set(ZB_ATTR_ETA, 12320); // Same at the 0.1 s resolution
+    TEST_ASSERT_FALSE(publisher.hasPending());
+    publisher.set(ZB_ATTR_ETA, 12350); // Rounds up to 12.4 s
+    TEST_ASSERT_TRUE(publisher.hasPending());
+
+    // A change that is reverted before the flush sends nothing
+    publisher.set(ZB_ATTR_ETA, 5000);
+    publisher.set(ZB_ATTR_ETA, 12300);
+    publisher.flush(100);
+    TEST_ASSERT_EQUAL(1, reports);
+}
+
+void test_min_interval_limits_rate()
+{
+    publisher.set(ZB_ATTR_SPEED, 1000);
+    publisher.flush(0);
+    publisher.set(ZB_ATTR_SPEED, 2000);
+    publisher.flush(500);
+    TEST_ASSERT_EQUAL(1, reports);
+    publisher.flush(1000);
+    TEST_ASSERT_EQUAL(2, reports);
+    TEST_ASSERT_EQUAL(2000, lastReported);
+}
+
+void test_hold_delays_everything()
+{
+    publisher.holdUntil(3000);
+    publisher.set(ZB_ATTR_SPEED, 1000);
+    publisher.set(ZB_ATTR_ETA, 1000);
+    publisher.flush(2999);
+    TEST_ASSERT_EQUAL(0, reports);
+    publisher.flush(3000);
+    TEST_ASSERT_EQUAL(2, reports);
+}
+
+void test_failed_report_is_retried()
+{
+    reportSucceeds = false;
+    publisher.set(ZB_ATTR_SPEED, 1000);
+    TEST_ASSERT_FALSE(publisher.flush(0));
+    TEST_ASSERT_TRUE(publisher.hasPending());
+    reportSucceeds = true;
+    TEST_ASSERT_TRUE(publisher.flush(100));
+    TEST_ASSERT_EQUAL(1, reports);
+}
+
+void test_snapshot_restores_persistent_attributes_only()
+{
+    publisher.set(ZB_ATTR_SPEED, 1000);
+    publisher.set(ZB_ATTR_ETA, 4000);
+    publisher.flush(0);
+    ZigbeePublishedSnapshot snapshot = publisher.snapshot();
+
+    setUp();
+    TEST_ASSERT_TRUE(publisher.restore(snapshot));
+    publisher.set(ZB_ATTR_SPEED, 1000);
+    publisher.set(ZB_ATTR_ETA, 4000);
+    publisher.flush(0);
+    TEST_ASSERT_EQUAL(1, reports);
+    TEST_ASSERT_EQUAL(4000, lastReported);
+
+    snapshot.version++;
+    TEST_ASSERT_FALSE(publisher.restore(snapshot));
+}
+
+void test_skipped_report_still_sets_local_attribute()
+{
+    ZigbeePublishedSnapshot snapshot = {};
+    snapshot.version = ZIGBEE_PUBLISHED_VERSION;
+    snapshot.validMask = 1 << ZB_ATTR_SPEED;
+    snapshot.values[ZB_ATTR_SPEED] = 1000;
+    TEST_ASSERT_TRUE(publisher.restore(snapshot));
+
+    publisher.holdUntil(3000);
+    publisher.set(ZB_ATTR_SPEED, 1000);
+    TEST_ASSERT_TRUE(publisher.hasPending());
+    publisher.flush(0); // Applied while reports are still held back
+    TEST_ASSERT_EQUAL(1, applies);
+    TEST_ASSERT_EQUAL(1000, lastApplied);
+    TEST_ASSERT_FALSE(publisher.hasPending());
+    publisher.flush(3000);
+    TEST_ASSERT_EQUAL(0, reports);
+}
+
+static void setSpeedTo2000()
+{
+    publisher.set(ZB_ATTR_SPEED, 2000);
+}
+
+void test_update_during_report_stays_pending()
+{
+    publisher.set(ZB_ATTR_SPEED, 1000);
+    duringReport = setSpeedTo2000;
+    publisher.flush(0);
+    TEST_ASSERT_EQUAL(1, reports);
+    TEST_ASSERT_EQUAL(1000, lastReported);
+    TEST_ASSERT_TRUE(publisher.hasPending());
+
+    publisher.flush(1000);
+    TEST_ASSERT_EQUAL(2, reports);
+    TEST_ASSERT_EQUAL(2000, lastReported);
+    TEST_ASSERT_EQUAL(2000, lastApplied);
+    TEST_ASSERT_FALSE(publisher.hasPending());
+}
+
+void test_immediate_update_skips_min_interval()
+{
+    publisher.set(ZB_ATTR_SPEED, 1000);
+    publisher.flush(0);
+    publisher.set(ZB_ATTR_SPEED, 2000, true);
+    publisher.flush(100);
+    TEST_ASSERT_EQUAL(2, reports);
+    TEST_ASSERT_EQUAL(2000, lastReported);
+}
+
+void test_assumed_value_is_not_reported_and_drops_pending()
+{
+    publisher.set(ZB_ATTR_SPEED, 1000);
+    publisher.flush(0);
+    publisher.set(ZB_ATTR_SPEED, 5000); // Held back by the min interval
+    publisher.assumePublished(ZB_ATTR_SPEED, 2400);
+    TEST_ASSERT_FALSE(publisher.hasPending());
+    TEST_ASSERT_TRUE(publisher.flush(2000)); // Nothing sent, but the snapshot changed
+    TEST_ASSERT_EQUAL(1, reports);
+    TEST_ASSERT_EQUAL(2400, publisher.snapshot().values[ZB_ATTR_SPEED]);
+
+    publisher.set(ZB_ATTR_SPEED, 1000); // Back to the value reported before the write
+    publisher.flush(3000);
+    TEST_ASSERT_EQUAL(2, reports);
+    TEST_ASSERT_EQUAL(1000, lastReported);
+    TEST_ASSERT_FALSE(publisher.flush(4000));
+}
+
+// --- Device ---
+
+struct Shared
+{
+    sim::World world;
+    uint64_t frames;
+    uint64_t firstFrameMs; // Relative to boot
+    uint64_t lastFrameMs;
+    uint64_t arrivedMs; // When the motor last stopped
+    uint64_t framesBeforeLocalChange;
+    uint8_t liftPercentage;
+    float speed;
+    float settings[4]; // Local analog outputs: stall sensitivity, bottom limit, top limit, speed
+};
+
+static uint64_t bootMs = 0;
+
+static void resetDevice()
+{
+    if (shared != nullptr)
+        *shared = Shared{};
+}
+
+static uint64_t framesCountedFrom = 0;
+
+static void recordFrames()
+{
+    static bool wasRunning = false;
+    bool running = sim::motorRunning();
+    if (wasRunning && !running)
+        shared->arrivedMs = sim::Kernel::instance().now() - bootMs;
+    wasRunning = running;
+
+    uint64_t frames = sim::zigbeeStats().frames - framesCountedFrom;
+    if (frames == shared->frames)
+        return;
+    uint64_t at = sim::Kernel::instance().now() - bootMs;
+    if (shared->frames == 0)
+        shared->firstFrameMs = at;
+    shared->lastFrameMs = at;
+    shared->frames = frames;
+}
+
+// Starts counting frames afresh from now.
+static void resetFrames()
+{
+    framesCountedFrom = sim::zigbeeStats().frames;
+    bootMs = sim::Kernel::instance().now();
+    shared->frames = 0;
+}
+
+static void bootDevice()
+{
+    bootMs = shared->world.nowMs;
+    sim::bootDevice(bootMs, recordFrames);
+}
+
+static void runFor(uint32_t ms)
+{
+    sim::Kernel &kernel = sim::Kernel::instance();
+    kernel.runUntil(kernel.now() + ms);
+}
+
+static void finish()
+{
+    ZigbeeWindowCovering *covering = static_cast<ZigbeeWindowCovering *>(Zigbee.simEndpoint(10));
+    shared->liftPercentage = covering->simLiftPercentage();
+    shared->speed = static_cast<ZigbeeAnalog *>(Zigbee.simEndpoint(15))->simAnalogOutput();
+    for (int i = 0; i < 4; i++)
+        shared->settings[i] = static_cast<ZigbeeAnalog *>(Zigbee.simEndpoint(12 + i))->simAnalogOutput();
+    shared->world.nowMs = sim::Kernel::instance().now() + 60000; // Power off for a minute
+}
+
+// What the device last saved as the coordinator's view of its attributes.
+static ZigbeePublishedSnapshot savedSnapshot()
+{
+    ZigbeePublishedSnapshot snapshot = {};
+    Preferences prefs;
+    prefs.begin("ZBCover");
+    prefs.getBytes("zbPublished", &snapshot, sizeof(snapshot));
+    prefs.end();
+    return snapshot;
+}
+
+// Boots the device in a child process, runs `scenario` and powers it off again.
+static void runBoot(void (*scenario)())
+{
+    shared->frames = 0;
+    shared->firstFrameMs = 0;
+    shared->lastFrameMs = 0;
+    fflush(stdout);
+    pid_t pid = fork();
+    TEST_ASSERT_TRUE(pid >= 0);
+    if (pid == 0)
+    {
+        bootDevice();
+        scenario();
+        finish();
+        fflush(stdout);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    TEST_ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+static void settle()
+{
+    runFor(ZIGBEE_BOOT_JITTER_MS + 1000);
+}
+
+static void settleAndConfigureAll()
+{
+    settle();
+    setCoverStallSensitivity(120);
+    setCoverBottomLimit(150);
+    setCoverTopLimit(20);
+    setCoverSpeed(7000.0f);
+    settle();
+}
+
+static void settleAndMove()
+{
+    settle();
+    resetFrames();
+    static_cast<ZigbeeWindowCovering *>(Zigbee.simEndpoint(10))->simGoToLiftPercentage(100);
+    runFor(30000);
+}
+
+static void settleAndConfigure()
+{
+    settle();
+    resetFrames();
+    setCoverSpeed(6000.0f);
+    setCoverSpeed(6500.0f);
+    setCoverSpeed(7000.0f);
+    setCoverStallSensitivity(getCoverState().stallSensitivity); // Unchanged
+    runFor(2000);
+}
+
+static void settleAndOverrideCoordinatorWrite()
+{
+    settle();
+    resetFrames();
+    float reportedSpeed = getCoverState().speed;
+    static_cast<ZigbeeAnalog *>(Zigbee.simEndpoint(15))->simWriteAnalogOutput(2400.0f);
+    runFor(2000);
+    shared->framesBeforeLocalChange = shared->frames;
+    setCoverSpeed(reportedSpeed); // Back to what the coordinator had before its write
+    runFor(2000);
+}
+
+void test_first_boot_sends_state_together_after_jitter()
+{
+    runBoot(settle);
+    TEST_ASSERT_EQUAL(5, shared->frames); // Lift and the four settings; the ETA is known to be 0
+    TEST_ASSERT_TRUE(shared->firstFrameMs <= ZIGBEE_BOOT_JITTER_MS + ZIGBEE_PUBLISH_INTERVAL_MS);
+    TEST_ASSERT_TRUE(shared->lastFrameMs - shared->firstFrameMs <= ZIGBEE_PUBLISH_INTERVAL_MS);
+    TEST_ASSERT_EQUAL_FLOAT(7500.0f, shared->speed);
+}
+
+void test_reboot_skips_values_the_coordinator_has()
+{
+    runBoot(settleAndConfigureAll);
+    runBoot(settle);
+    TEST_ASSERT_EQUAL(1, shared->frames); // Only the lift, which is not persisted
+    // The skipped values are still set on the local endpoints
+    TEST_ASSERT_EQUAL_FLOAT(120.0f, shared->settings[0]);
+    TEST_ASSERT_EQUAL_FLOAT(150.0f, shared->settings[1]);
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, shared->settings[2]);
+    TEST_ASSERT_EQUAL_FLOAT(7000.0f, shared->settings[3]);
+}
+
+void test_move_frames_are_rate_limited()
+{
+    runBoot(settleAndMove);
+    // ETA at start and arrival, a lift report every ZIGBEE_LIFT_MIN_INTERVAL_MS and the final lift
+    TEST_ASSERT_TRUE(shared->frames >= 3);
+    TEST_ASSERT_TRUE(shared->frames <= 2 + 16000 / ZIGBEE_LIFT_MIN_INTERVAL_MS + 2);
+    TEST_ASSERT_EQUAL_UINT8(100, shared->liftPercentage);
+    // The settled lift goes out with the next position update (every second), not after the interval
+    TEST_ASSERT_TRUE(shared->lastFrameMs - shared->arrivedMs <= 1000 + ZIGBEE_PUBLISH_INTERVAL_MS);
+}
+
+void test_setting_changes_coalesce()
+{
+    runBoot(settleAndConfigure);
+    TEST_ASSERT_EQUAL(1, shared->frames);
+    TEST_ASSERT_EQUAL_FLOAT(7000.0f, shared->speed);
+}
+
+void test_coordinator_write_is_not_echoed_but_local_change_back_is()
+{
+    runBoot(settleAndOverrideCoordinatorWrite);
+    TEST_ASSERT_EQUAL(0, shared->framesBeforeLocalChange);
+    TEST_ASSERT_EQUAL(1, shared->frames);
+    TEST_ASSERT_EQUAL_FLOAT(7500.0f, shared->speed);
+    TEST_ASSERT_EQUAL(7500, savedSnapshot().values[ZB_ATTR_SPEED]);
+
+    runBoot(settle);
+    TEST_ASSERT_EQUAL(1, shared->frames); // Only the lift: the snapshot matches the coordinator
+}
+
+int main(int argc, char **argv)
+{
+    void *memory = mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+        return 1;
+    shared = new (memory) Shared{};
+    sim::worldPtr() = &shared->world;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_updates_between_flushes_coalesce);
+    RUN_TEST(test_unchanged_values_are_skipped);
+    RUN_TEST(test_min_interval_limits_rate);
+    RUN_TEST(test_hold_delays_everything);
+    RUN_TEST(test_failed_report_is_retried);
+    RUN_TEST(test_snapshot_restores_persistent_attributes_only);
+    RUN_TEST(test_assumed_value_is_not_reported_and_drops_pending);
+    RUN_TEST(test_skipped_report_still_sets_local_attribute);
+    RUN_TEST(test_update_during_report_stays_pending);
+    RUN_TEST(test_immediate_update_skips_min_interval);
+    RUN_TEST(test_first_boot_sends_state_together_after_jitter);
+    RUN_TEST(test_reboot_skips_values_the_coordinator_has);
+    RUN_TEST(test_move_frames_are_rate_limited);
+    RUN_TEST(test_setting_changes_coalesce);
+    RUN_TEST(test_coordinator_write_is_not_echoed_but_local_change_back_is);
+    return UNITY_END();
+}